@@ -34,7 +34,10 @@
 #include "control_factory.h"
 #include "transform.h"
 
-#include "zephyr/console/console.h"
+#include "console_input.h"
+#include "retained_state.h"
+#include "persistent_parameters.h"
+#include "nvs_storage.h"
 
 /* --------------SETUP AND LOOP FUNCTIONS DECLARATION------------------- */
 
@@ -54,7 +57,14 @@ void read_measurements();
 
 /* -------------- VARIABLES DECLARATIONS------------------- */
 
+/* Control task period. The default 100 µs leaves a large margin; defining
+ * OWNVERTER_FAST_CONTROL (see build_flags in platformio.ini) selects the
+ * 25 µs (40 kHz) configuration whose cycle budget is given in README.md. */
+#ifdef OWNVERTER_FAST_CONTROL
+static const float32_t T_control = 25e-6F; // Control task period (s)
+#else
 static const float32_t T_control = 100e-6F; // Control task period (s)
+#endif
 static const uint32_t T_control_micro = (uint32_t)(T_control * 1.e6F); // Control task period (integer number of µs)
 
 /* SINUSOIDAL SIGNAL GENERATION VARIABLES */
@@ -118,15 +128,40 @@ void setup_routine()
 	/* Setup all the measurements */
 	shield.sensors.enableDefaultOwnverterSensors();
 
+	/* Power-on operating point, saved from the serial monitor */
+	persistent_parameters_register(0, 1, PARAMETER_FLOAT32, &v_freq);
+	persistent_parameters_register(0, 2, PARAMETER_FLOAT32, &duty_offset);
+	persistent_parameters_register(0, 3, PARAMETER_FLOAT32, &duty_amplitude);
+	persistent_parameters_load();
+
+	/* Keep the previous operating point after a software or watchdog reset.
+	 * The mode is not retained: the board always boots in idle mode. */
+	retained_state_register(RETAINED_STATE_ID_USER, &v_freq, sizeof(v_freq));
+	retained_state_register(RETAINED_STATE_ID_USER + 1, &duty_offset, sizeof(duty_offset));
+	retained_state_register(RETAINED_STATE_ID_USER + 2, &duty_amplitude, sizeof(duty_amplitude));
+
 	/* Declare tasks */
 	uint32_t app_task_number = task.createBackground(status_display_task);
 	uint32_t com_task_number = task.createBackground(user_interface_task);
 	task.createCritical(control_task, T_control_micro);
 
-	/* Start tasks */
+	/* Start the critical task first: data acquisition is needed to calibrate */
+	task.startCritical();
+
+	/* Power stage is stopped until power mode is requested, which the user
+	 * interface task can only do once started: calibrate current sensors
+	 * offsets. After a warm boot, offsets in use are retained. */
+	if (retained_state_is_warm_boot() == false)
+	{
+		const sensor_t current_sensors[] = {I1_LOW, I2_LOW, I3_LOW, I_HIGH};
+		int8_t calibration = shield.sensors.calibrateOffsets(current_sensors, 4);
+		if (calibration != 0) {
+			printk("Current sensors offsets calibration failed (%d)\n", calibration);
+		}
+	}
+
 	task.startBackground(app_task_number);
 	task.startBackground(com_task_number);
-	task.startCritical();
 }
 
 /* --------------LOOP FUNCTIONS (TASKS) ------------------------------- */
@@ -135,12 +170,19 @@ void setup_routine()
  * User interface task, running in a loop in the background.
  * It allows controlling the application through the serial monitor.
  *
- * It waits for the user to press a key to select an action.
+ * It polls the console for a key pressed by the user to select an action,
+ * without blocking when no key was pressed.
  * In particular, 'h' displays the help menu.
  */
 void user_interface_task()
 {
-	received_serial_char = console_getchar();
+	int16_t c = console_input_poll_char();
+	if (c < 0) {
+		task.suspendBackgroundMs(20);
+		return;
+	}
+
+	received_serial_char = c;
 	switch (received_serial_char) {
 	case 'h':
 		/* ----------SERIAL INTERFACE MENU----------------------- */
@@ -153,6 +195,8 @@ void user_interface_task()
 				"|     press j/l : duty cycle ampl./offset DOWN |\n"
 				"|     press f   : frequency UP                 |\n"
 				"|     press v   : frequency DOWN               |\n"
+				"|     press s   : save settings as default     |\n"
+				"|     press r   : restore firmware settings    |\n"
 				"|______________________________________________|\n\n");
 
 		/* ------------------------------------------------------ */
@@ -189,6 +233,15 @@ void user_interface_task()
 		v_freq -= freq_increment;
 		printk("Frequency DOWN (%.2f Hz) \n", (double) v_freq);
 		break;
+	case 's':
+		persistent_parameters_save();
+		nvs_storage_flush();
+		printk("Settings saved as default\n");
+		break;
+	case 'r':
+		persistent_parameters_restore_defaults();
+		printk("Firmware settings restored\n");
+		break;
 	default:
 		break;
 	}
@@ -198,17 +251,18 @@ void user_interface_task()
  * Board status display task, called pseudo-periodically.
  * It displays board measurements on the serial monitor
  * 
- * It also sets the board LED (blinking when POWER_MODE).
+ * It also sets the board LED pattern (blinking when POWER_MODE),
+ * which is then played by hardware.
  */
 void status_display_task()
 {
 	if (mode == IDLE_MODE) {
-		spin.led.turnOn(); // Constantly ON led when IDLE
+		spin.led.setPattern(LED_PATTERN_IDLE); // Constantly ON led when IDLE
 		// Display state:
 		printk("IDL: ");
 
 	} else if (mode == POWER_MODE) {
-		spin.led.toggle(); // Blinking LED when POWER
+		spin.led.setPattern(LED_PATTERN_POWER); // Blinking LED when POWER
 		// Display state:
 		printk("POW: ");
 	}
@@ -219,8 +273,12 @@ void status_display_task()
 	);
 	printk("@%.0f Hz ", (double) v_freq);
 	printk("| ");
-	printk("Vh %5.2f V, ", (double) V_high);
-	printk("Ih %4.2f A, ", (double) I_high);
+	// Measurements are copied from the snapshot published by the control task
+	sensors_snapshot_t snapshot;
+	if (shield.sensors.readSnapshot(snapshot) == 0) {
+		printk("Vh %5.2f V, ", (double) snapshot.get(V_HIGH));
+		printk("Ih %4.2f A, ", (double) snapshot.get(I_HIGH));
+	}
 	printk("\n");
 	task.suspendBackgroundMs(200);
 }
@@ -262,6 +320,9 @@ inline void read_measurements()
 	/* Apply filters */
 	// Smooth V_high (lowpass)
 	V_high_filt = vHigh_filter.calculateWithReturn(V_high);
+
+	/* Make the values read in this period available to background tasks */
+	shield.sensors.publishSnapshot();
 }
 
 /* Compute sinusoidal duty cycles for each phase a,b,c 
@@ -283,7 +344,8 @@ inline void compute_duties()
 
 /**
  * This is the code loop of the critical task.
- * It is executed every T_control seconds (100 µs by default).
+ * It is executed every T_control seconds (100 µs by default, 25 µs with
+ * OWNVERTER_FAST_CONTROL).
  * 
  * Actions:
  * - measure voltage and currents (in subfunction)
@@ -123,6 +123,12 @@ uint32_t adc_get_enabled_channels_count(uint8_t adc_number)
 	return enabled_channels_count[adc_index];
 }
 
+uint32_t adc_get_sequence_time_ns(uint8_t adc_number)
+{
+	return adc_get_enabled_channels_count(adc_number) *
+		   adc_core_get_conversion_time_ns();
+}
+
 void adc_configure_use_dma(uint8_t adc_number, bool use_dma)
 {
 	if ( (adc_number == 0) || (adc_number > NUMBER_OF_ADCS) )
@@ -133,9 +139,15 @@ void adc_configure_use_dma(uint8_t adc_number, bool use_dma)
 
 void adc_start()
 {
-	/* Initialize ADCs */
+	/* Initialize ADCs that have channels enabled */
 
-	adc_core_init();
+	for (uint8_t adc_num = 1 ; adc_num <= NUMBER_OF_ADCS ; adc_num++)
+	{
+		if (enabled_channels_count[adc_num-1] > 0)
+		{
+			adc_core_init(adc_num);
+		}
+	}
 
 	/** Pre-enable configuration
 	 * Nothing here for now.
@@ -146,9 +158,12 @@ void adc_start()
 
 	/* Enable ADCs */
 
-	for (int adc_num = 1 ; adc_num <= NUMBER_OF_ADCS ; adc_num++)
+	for (uint8_t adc_num = 1 ; adc_num <= NUMBER_OF_ADCS ; adc_num++)
 	{
-		adc_core_enable(adc_num);
+		if (enabled_channels_count[adc_num-1] > 0)
+		{
+			adc_core_enable(adc_num);
+		}
 	}
 
 	/* Post-enable configuration */
@@ -270,5 +285,12 @@ void adc_stop()
 void adc_trigger_software_conversion(uint8_t adc_number,
 									 uint8_t number_of_acquisitions)
 {
+	if ( (adc_number == 0) || (adc_number > NUMBER_OF_ADCS) )
+		return;
+
+	/* ADCs without enabled channel are not powered */
+	if (enabled_channels_count[adc_number-1] == 0)
+		return;
+
 	adc_core_start(adc_number, number_of_acquisitions);
 }
@@ -143,6 +143,16 @@ void adc_remove_channel(uint8_t adc_number, uint8_t channel);
  */
 uint32_t adc_get_enabled_channels_count(uint8_t adc_number);
 
+/**
+ * @brief  Returns the time an ADC takes to convert its whole sequence
+ *         of enabled channels after a single trigger.
+ *
+ * @param  adc_number Number of the ADC.
+ * @return Sequence conversion time in nanoseconds, 0 if the ADC number
+ *         is invalid or no channel is enabled.
+ */
+uint32_t adc_get_sequence_time_ns(uint8_t adc_number);
+
 /**
  * @brief Configures an ADC to use DMA.
  *
@@ -159,6 +169,9 @@ void adc_configure_use_dma(uint8_t adc_number, bool use_dma);
 
 /**
  * @brief Starts all configured ADCs.
+ *
+ * Only ADCs with at least one enabled channel are clocked, calibrated
+ * and enabled. Other ADCs stay in deep power down.
  */
 void adc_start();
 
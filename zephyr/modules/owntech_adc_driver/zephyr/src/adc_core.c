@@ -29,6 +29,8 @@
 
 /* Zephyr */
 #include <zephyr/kernel.h>
+#include <zephyr/drivers/clock_control.h>
+#include <zephyr/drivers/clock_control/stm32_clock_control.h>
 
 /* STM32 LL */
 #include <stm32_ll_bus.h>
@@ -37,6 +39,12 @@
 /** @brief Defines the number of ADCs */
 #define NUMBER_OF_ADCS 5
 
+/** @brief ADC clock cycles per conversion: 12.5 sampling + 12.5 SAR */
+#define ADC_CYCLES_PER_CONVERSION 25
+
+/** @brief Divider of the synchronous ADC clock (LL_ADC_CLOCK_SYNC_PCLK_DIV4) */
+#define ADC_CLOCK_DIVIDER 4
+
 
 /*
   Helper functions
@@ -413,33 +421,64 @@ void adc_core_configure_channel(uint8_t adc_num, uint8_t channel, uint8_t rank)
 								  LL_ADC_SAMPLINGTIME_12CYCLES_5);
 }
 
-void adc_core_init()
+uint32_t adc_core_get_conversion_time_ns()
 {
-	static bool initialized = false;
+	const struct device* clk = DEVICE_DT_GET(STM32_CLOCK_CONTROL_NODE);
+	struct stm32_pclken pclken =
+	{
+		.bus = STM32_CLOCK_BUS_AHB2,
+		.enr = LL_AHB2_GRP1_PERIPH_ADC12
+	};
+	uint32_t ahb_clock = 0;
+
+	if (clock_control_get_rate(clk,
+							   (clock_control_subsys_t)&pclken,
+							   &ahb_clock) != 0)
+	{
+		return 0;
+	}
+
+	uint32_t adc_clock = ahb_clock / ADC_CLOCK_DIVIDER;
+
+	return (uint32_t)(((uint64_t)ADC_CYCLES_PER_CONVERSION * 1000000000U +
+					   adc_clock - 1) / adc_clock);
+}
+
+void adc_core_init(uint8_t adc_num)
+{
+	static bool adc_initialized[NUMBER_OF_ADCS] = {0};
+	static bool adc12_clock_enabled  = false;
+	static bool adc345_clock_enabled = false;
+
+	if ( (adc_num == 0) || (adc_num > NUMBER_OF_ADCS) )
+		return;
 
-	if (initialized == false)
+	if (adc_initialized[adc_num-1] == true)
+		return;
+
+	/* Enable clock of the ADC pair or triplet the ADC belongs to, and set
+	 * their common clock while all of them are still disabled.
+	 * Refer to RM 21.4.3 and 21.7.2 */
+	if ( (adc_num <= 2) && (adc12_clock_enabled == false) )
 	{
-		/* Enable ADCs clocks */
 		LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_ADC12);
+		LL_ADC_SetCommonClock(ADC12_COMMON, LL_ADC_CLOCK_SYNC_PCLK_DIV4);
+
+		adc12_clock_enabled = true;
+	}
+	else if ( (adc_num >= 3) && (adc345_clock_enabled == false) )
+	{
 		LL_AHB2_GRP1_EnableClock(LL_AHB2_GRP1_PERIPH_ADC345);
+		LL_ADC_SetCommonClock(ADC345_COMMON, LL_ADC_CLOCK_SYNC_PCLK_DIV4);
 
-		/* Wake-up ADCs */
-		for (int i = 1 ; i <= NUMBER_OF_ADCS ; i++)
-		{
-			_adc_core_wakeup(i);
-		}
+		adc345_clock_enabled = true;
+	}
 
-		/* Set common clock between ADC 1 and ADC 2 */
-		/* Refer to RM 21.4.3 and 21.7.2 */
-		LL_ADC_SetCommonClock(ADC12_COMMON, LL_ADC_CLOCK_SYNC_PCLK_DIV4);
-		LL_ADC_SetCommonClock(ADC345_COMMON, LL_ADC_CLOCK_SYNC_PCLK_DIV4);
+	/* Wake-up ADC */
+	_adc_core_wakeup(adc_num);
 
-		/* Calibrate ADCs */
-		for (int i = 1 ; i <= NUMBER_OF_ADCS ; i++)
-		{
-			_adc_core_calibrate(i);
-		}
+	/* Calibrate ADC */
+	_adc_core_calibrate(adc_num);
 
-		initialized = true;
-	}
+	adc_initialized[adc_num-1] = true;
 }
@@ -40,10 +40,14 @@ extern "C" {
 /* Init, enable, start, stop */
 
 /**
- * @brief ADC initialization procedure for : `ADC 1`,`ADC 2`,`ADC 3`,`ADC 4`
- * 
+ * @brief ADC initialization procedure: clocks the ADC, wakes it up
+ *        and calibrates it. Does nothing if the ADC is already initialized.
+ *
+ * ADCs that are never initialized stay unclocked in deep power down.
+ *
+ * @param adc_num Number of the ADC (`1` to `5`) to initialize
  */
-void adc_core_init();
+void adc_core_init(uint8_t adc_num);
 
 /**
  * @brief ADC enable. 
@@ -144,6 +148,15 @@ void adc_core_set_channel_differential(uint8_t adc_num,
  */
 void adc_core_configure_channel(uint8_t adc_num, uint8_t channel, uint8_t rank);
 
+/**
+ * @brief Returns the time taken to convert one channel, i.e. its
+ *        sampling time plus the successive approximation time, at the
+ *        synchronous ADC clock derived from the current AHB clock.
+ *
+ * @return Conversion time of one channel in nanoseconds, rounded up.
+ */
+uint32_t adc_core_get_conversion_time_ns();
+
 
 #ifdef __cplusplus
 }
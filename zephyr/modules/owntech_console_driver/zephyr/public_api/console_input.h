@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/**
+ * @brief Console input driver.
+ *
+ * Characters received by the console are stored from interrupt in a ring
+ * buffer. They can then be read one by one, or assembled in lines, without
+ * blocking the calling thread. This allows a background task to serve the
+ * user interface along with other duties.
+ *
+ * This driver replaces the Zephyr `console_getchar()` function: both
+ * can not be used at the same time.
+ */
+
+#ifndef CONSOLE_INPUT_H_
+#define CONSOLE_INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start console reception.
+ *
+ * Called once at board startup.
+ *
+ * @return `0` on success, `-1` if the console device is not ready.
+ */
+int8_t console_input_init();
+
+/**
+ * @brief Get a received character if any. Does not block.
+ *
+ * @return The character, or `-1` if no character was received.
+ */
+int16_t console_input_poll_char();
+
+/**
+ * @brief Wait for a character to be received.
+ *
+ * @return The received character.
+ *
+ * @warning Blocks the calling thread: do not use in a critical task.
+ */
+char console_input_getchar();
+
+/**
+ * @brief Get a complete line if one was received. Does not block.
+ *
+ * Received characters are accumulated in an internal line buffer at each
+ * call, handling backspace, until an end of line (`\n`) is received.
+ * Carriage returns are ignored.
+ *
+ * @param[out] line Buffer receiving the line, without the end of line
+ *                  character, and terminated with `\0`
+ * @param[in]  size Size of `line` buffer
+ *
+ * @return Length of the line, or `-1` if no complete line is available yet.
+ *         A line longer than `CONFIG_OWNTECH_CONSOLE_DRIVER_LINE_SIZE` or
+ *         than `size` is returned in several parts.
+ */
+int16_t console_input_poll_line(char* line, size_t size);
+
+/**
+ * @brief Enable echo of characters when they are assembled in a line.
+ *
+ * @param echo `true` to send back received characters to the console.
+ */
+void console_input_set_echo(bool echo);
+
+/**
+ * @brief Get the number of characters dropped because the reception
+ *        buffer was full.
+ */
+uint32_t console_input_get_dropped_count();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_INPUT_H_ */
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/* Std lib */
+#include <string.h>
+
+/* Zephyr */
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+
+/* Current file header */
+#include "console_input.h"
+
+
+/**
+ *  DT definition
+ */
+
+static const struct device* console_dev =
+                                      DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+
+/**
+ *  Local variables
+ */
+
+static const uint16_t RX_BUFFER_SIZE = CONFIG_OWNTECH_CONSOLE_DRIVER_RX_BUFFER_SIZE;
+static const uint16_t LINE_SIZE      = CONFIG_OWNTECH_CONSOLE_DRIVER_LINE_SIZE;
+
+/* Reception ring: written by interrupt, read by thread */
+static uint8_t rx_buffer[CONFIG_OWNTECH_CONSOLE_DRIVER_RX_BUFFER_SIZE];
+static volatile uint16_t rx_write_index = 0;
+static volatile uint16_t rx_read_index  = 0;
+static volatile uint32_t rx_dropped_count = 0;
+
+/* Line being assembled */
+static char line_buffer[CONFIG_OWNTECH_CONSOLE_DRIVER_LINE_SIZE];
+static uint16_t line_length = 0;
+static bool line_echo = false;
+
+static K_SEM_DEFINE(rx_sem, 0, 1);
+
+/* Private API */
+
+/**
+ * Console interrupt
+ * Moves received characters to the ring buffer.
+ */
+static void _console_input_isr(const struct device* dev, void* user_data)
+{
+	ARG_UNUSED(user_data);
+
+	if (uart_irq_update(dev) == 0)
+	{
+		return;
+	}
+
+	while (uart_irq_rx_ready(dev))
+	{
+		uint8_t c;
+
+		if (uart_fifo_read(dev, &c, 1) != 1)
+		{
+			break;
+		}
+
+		uint16_t next_index = (rx_write_index + 1) % RX_BUFFER_SIZE;
+
+		/* One slot is kept empty to tell full from empty */
+		if (next_index == rx_read_index)
+		{
+			rx_dropped_count++;
+			continue;
+		}
+
+		rx_buffer[rx_write_index] = c;
+
+		/* Character must be stored before it is made visible */
+		compiler_barrier();
+
+		rx_write_index = next_index;
+	}
+
+	k_sem_give(&rx_sem);
+}
+
+/**
+ * Return the current line and clear the line buffer.
+ */
+static int16_t _console_input_take_line(char* line, size_t size)
+{
+	uint16_t length = line_length;
+
+	if (length > size - 1)
+	{
+		length = size - 1;
+	}
+
+	memcpy(line, line_buffer, length);
+	line[length] = '\0';
+
+	/* Keep what did not fit for next call */
+	memmove(line_buffer, &line_buffer[length], line_length - length);
+	line_length -= length;
+
+	return length;
+}
+
+/* Public API */
+
+int8_t console_input_init()
+{
+	if (device_is_ready(console_dev) == false)
+	{
+		return -1;
+	}
+
+	uart_irq_callback_user_data_set(console_dev, _console_input_isr, NULL);
+	uart_irq_rx_enable(console_dev);
+
+	return 0;
+}
+
+int16_t console_input_poll_char()
+{
+	uint16_t read_index = rx_read_index;
+
+	if (read_index == rx_write_index)
+	{
+		return -1;
+	}
+
+	uint8_t c = rx_buffer[read_index];
+
+	rx_read_index = (read_index + 1) % RX_BUFFER_SIZE;
+
+	return c;
+}
+
+char console_input_getchar()
+{
+	int16_t c;
+
+	while ((c = console_input_poll_char()) < 0)
+	{
+		k_sem_take(&rx_sem, K_FOREVER);
+	}
+
+	return (char)c;
+}
+
+int16_t console_input_poll_line(char* line, size_t size)
+{
+	if ( (line == NULL) || (size == 0) )
+	{
+		return -1;
+	}
+
+	int16_t c;
+
+	while ((c = console_input_poll_char()) >= 0)
+	{
+		if (c == '\r')
+		{
+			continue;
+		}
+
+		if (line_echo == true)
+		{
+			printk("%c", (char)c);
+		}
+
+		if (c == '\n')
+		{
+			return _console_input_take_line(line, size);
+		}
+
+		/* Backspace */
+		if (c == 0x08)
+		{
+			if (line_length > 0)
+			{
+				line_length--;
+			}
+			continue;
+		}
+
+		line_buffer[line_length] = (char)c;
+		line_length++;
+
+		if ( (line_length >= LINE_SIZE) || (line_length >= size - 1) )
+		{
+			return _console_input_take_line(line, size);
+		}
+	}
+
+	return -1;
+}
+
+void console_input_set_echo(bool echo)
+{
+	line_echo = echo;
+}
+
+uint32_t console_input_get_dropped_count()
+{
+	return rx_dropped_count;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/**
+ * @brief CORDIC co-processor driver.
+ *
+ * The CORDIC is configured at boot by cordic_init() to compute the
+ * cosine/sine pair of a q1.31 angle (angle / pi) in 6 cycles (24
+ * iterations, about 2^-20 accuracy). Computation functions are inline
+ * and rely on the zero-overhead mode of the peripheral: reading the
+ * result stalls the bus until it is ready, so no polling is needed.
+ *
+ * For instance, three-phase sinusoidal duty cycles can be computed as:
+ *
+ *     float32_t sin_abc[3];
+ *     float32_t cos_abc[3];
+ *     cordic_sincos_3phase(angle, sin_abc, cos_abc);
+ *     duty_a = offset + amplitude * sin_abc[0];
+ *
+ * Transforms of the control library compute their own sines: to use the
+ * CORDIC instead, rotate the Clarke components with cordic_sincos().
+ */
+
+#ifndef CORDIC_H_
+#define CORDIC_H_
+
+#include <stdint.h>
+#include "arm_math.h"
+#include <stm32_ll_cordic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief 2*pi/3 as a q1.31 angle (angle / pi) */
+#define CORDIC_Q31_2PI_3 (0x55555555U)
+
+/** @brief Conversion factor from q1.31 to float */
+#define CORDIC_Q31_TO_FLOAT (1.0F / 2147483648.0F)
+
+/** @brief Conversion factor from radians to q1.31 angle */
+#define CORDIC_RAD_TO_Q31 (2147483648.0F / PI)
+
+/** @brief callback function called at the end of a DMA computation */
+typedef void (*cordic_callback_t)();
+
+/**
+ * @brief Initialize the CORDIC for cosine/sine computation.
+ *
+ * This is done automatically at boot. Call it again only if the
+ * CORDIC was reconfigured by other code.
+ */
+void cordic_init();
+
+/**
+ * @brief Convert an angle in radians to the q1.31 format of the CORDIC.
+ *
+ * @param angle Angle in radians, between `-PI` and `2*PI`, e.g. the
+ *              output of `ot_modulo_2pi()`.
+ * @return Angle divided by pi, in q1.31. Angles above pi are wrapped to
+ *         the negative half-turn.
+ */
+static inline int32_t cordic_angle_to_q31(float32_t angle)
+{
+	if (angle > PI)
+	{
+		angle -= 2 * PI;
+	}
+
+	/* The FPU conversion saturates at the +pi bound */
+	return (int32_t)(angle * CORDIC_RAD_TO_Q31);
+}
+
+/**
+ * @brief Compute the sine and cosine of an angle.
+ *
+ * @param[in]  angle   Angle in radians, between `-PI` and `2*PI`
+ * @param[out] sin_out Sine of the angle
+ * @param[out] cos_out Cosine of the angle
+ */
+static inline void cordic_sincos(float32_t angle,
+								 float32_t* sin_out,
+								 float32_t* cos_out)
+{
+	LL_CORDIC_WriteData(CORDIC, (uint32_t)cordic_angle_to_q31(angle));
+
+	*cos_out = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+	*sin_out = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+}
+
+/**
+ * @brief Compute the sine and cosine of the three phase angles
+ *        `angle`, `angle - 2*PI/3` and `angle + 2*PI/3`.
+ *
+ * Computations are pipelined: the next angle is written while the
+ * previous computation is ongoing and starts as soon as its results are
+ * read. Phase shifts are applied in q1.31, where integer wrap-around is
+ * the modulo 2*pi.
+ *
+ * @param[in]  angle   Angle of phase a in radians, between `-PI` and `2*PI`
+ * @param[out] sin_abc Array of 3 sines, for phases a, b and c
+ * @param[out] cos_abc Array of 3 cosines, for phases a, b and c
+ */
+static inline void cordic_sincos_3phase(float32_t angle,
+										float32_t* sin_abc,
+										float32_t* cos_abc)
+{
+	uint32_t angle_a = (uint32_t)cordic_angle_to_q31(angle);
+
+	LL_CORDIC_WriteData(CORDIC, angle_a);
+	LL_CORDIC_WriteData(CORDIC, angle_a - CORDIC_Q31_2PI_3);
+
+	cos_abc[0] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+	sin_abc[0] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+
+	LL_CORDIC_WriteData(CORDIC, angle_a + CORDIC_Q31_2PI_3);
+
+	cos_abc[1] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+	sin_abc[1] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+
+	cos_abc[2] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+	sin_abc[2] = (int32_t)LL_CORDIC_ReadData(CORDIC) * CORDIC_Q31_TO_FLOAT;
+}
+
+#ifdef CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA
+
+/**
+ * @brief Compute a buffer of cosine/sine pairs in the background using DMA.
+ *
+ * @param[in]  angles_q31  Array of `count` angles in q1.31 format
+ *                         (see `cordic_angle_to_q31()`)
+ * @param[out] results_q31 Array of `2 * count` results in q1.31 format:
+ *                         cosine then sine for each angle
+ * @param[in]  count       Number of angles
+ * @param[in]  callback    Function called when all results are available,
+ *                         can be `NULL`
+ *
+ * @return `0` if the transfer was started, `-1` if DMA is not available
+ *         or a transfer is already ongoing.
+ *
+ * @warning Inline functions of this driver must not be used while a DMA
+ *          computation is ongoing.
+ */
+int8_t cordic_dma_sincos(const int32_t* angles_q31,
+						 int32_t* results_q31,
+						 uint32_t count,
+						 cordic_callback_t callback);
+
+#endif /* CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORDIC_H_ */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/* Zephyr */
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+
+/* STM32 LL */
+#include <stm32_ll_bus.h>
+#include <stm32_ll_cordic.h>
+
+#ifdef CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA
+#include <stm32_ll_dma.h>
+#include <stm32_ll_dmamux.h>
+#endif
+
+/* Current file header */
+#include "cordic.h"
+
+
+#ifdef CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA
+
+/**
+ *  Local variables
+ */
+
+/**
+ * DMA 1 channels are used by the ADCs, RS485 and DAC, and DMA 2
+ * channels 1 to 3 by USART 1 and the LED, 6 and 7 by the FMAC:
+ * DMA 2 is driven directly with LL drivers.
+ */
+#define CORDIC_DMA               DMA2
+#define CORDIC_DMA_WRITE_CHANNEL LL_DMA_CHANNEL_4
+#define CORDIC_DMA_READ_CHANNEL  LL_DMA_CHANNEL_5
+
+static cordic_callback_t dma_user_callback = NULL;
+static volatile bool dma_busy = false;
+
+/* Private API */
+
+/**
+ * DMA interrupt
+ * Called when the read channel has retrieved all results.
+ */
+static void _cordic_dma_callback(const void* arg)
+{
+	ARG_UNUSED(arg);
+
+	if (LL_DMA_IsActiveFlag_TC5(CORDIC_DMA) == 0)
+	{
+		return;
+	}
+
+	LL_DMA_ClearFlag_TC5(CORDIC_DMA);
+
+	LL_CORDIC_DisableDMAReq_WR(CORDIC);
+	LL_CORDIC_DisableDMAReq_RD(CORDIC);
+
+	LL_DMA_DisableChannel(CORDIC_DMA, CORDIC_DMA_WRITE_CHANNEL);
+	LL_DMA_DisableChannel(CORDIC_DMA, CORDIC_DMA_READ_CHANNEL);
+
+	dma_busy = false;
+
+	if (dma_user_callback != NULL)
+	{
+		dma_user_callback();
+	}
+}
+
+/**
+ * Configure one DMA channel for 32-bit transfers between
+ * the CORDIC and memory.
+ */
+static void _cordic_dma_configure_channel(uint32_t channel,
+										  uint32_t request,
+										  uint32_t direction,
+										  uint32_t peripheral_address,
+										  uint32_t memory_address,
+										  uint32_t length)
+{
+	LL_DMA_InitTypeDef DMA_InitStruct = {0};
+
+	DMA_InitStruct.Direction = direction;
+	DMA_InitStruct.PeriphOrM2MSrcAddress = peripheral_address;
+	DMA_InitStruct.MemoryOrM2MDstAddress = memory_address;
+	DMA_InitStruct.Mode = LL_DMA_MODE_NORMAL;
+	DMA_InitStruct.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_WORD;
+	DMA_InitStruct.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_WORD;
+	DMA_InitStruct.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+	DMA_InitStruct.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+	DMA_InitStruct.PeriphRequest = request;
+	DMA_InitStruct.NbData = length;
+	DMA_InitStruct.Priority = LL_DMA_PRIORITY_LOW;
+
+	LL_DMA_DisableChannel(CORDIC_DMA, channel);
+	LL_DMA_Init(CORDIC_DMA, channel, &DMA_InitStruct);
+}
+
+#endif /* CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA */
+
+/* Public API */
+
+void cordic_init()
+{
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_CORDIC);
+
+	/**
+	 * Write the modulus once: when a single argument is written
+	 * afterwards, the CORDIC keeps using this value for the second one.
+	 */
+	LL_CORDIC_Config(CORDIC,
+					 LL_CORDIC_FUNCTION_COSINE,
+					 LL_CORDIC_PRECISION_6CYCLES,
+					 LL_CORDIC_SCALE_0,
+					 LL_CORDIC_NBWRITE_2,
+					 LL_CORDIC_NBREAD_2,
+					 LL_CORDIC_INSIZE_32BITS,
+					 LL_CORDIC_OUTSIZE_32BITS);
+
+	LL_CORDIC_WriteData(CORDIC, 0);
+	LL_CORDIC_WriteData(CORDIC, 0x7FFFFFFF);
+	(void)LL_CORDIC_ReadData(CORDIC);
+	(void)LL_CORDIC_ReadData(CORDIC);
+
+	/* One angle in, cosine and sine out */
+	LL_CORDIC_SetNbWrite(CORDIC, LL_CORDIC_NBWRITE_1);
+
+#ifdef CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMAMUX1);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+	IRQ_CONNECT(DMA2_Channel5_IRQn, 0, _cordic_dma_callback, NULL, 0);
+	irq_enable(DMA2_Channel5_IRQn);
+#endif
+}
+
+#ifdef CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA
+
+int8_t cordic_dma_sincos(const int32_t* angles_q31,
+						 int32_t* results_q31,
+						 uint32_t count,
+						 cordic_callback_t callback)
+{
+	if ( (count == 0) || (dma_busy == true) )
+	{
+		return -1;
+	}
+
+	dma_busy = true;
+	dma_user_callback = callback;
+
+	/* Results are read first so that no result is missed */
+	_cordic_dma_configure_channel(
+		CORDIC_DMA_READ_CHANNEL,
+		LL_DMAMUX_REQ_CORDIC_READ,
+		LL_DMA_DIRECTION_PERIPH_TO_MEMORY,
+		LL_CORDIC_DMA_GetRegAddr(CORDIC, LL_CORDIC_DMA_REG_DATA_OUT),
+		(uint32_t)results_q31,
+		2 * count);
+
+	_cordic_dma_configure_channel(
+		CORDIC_DMA_WRITE_CHANNEL,
+		LL_DMAMUX_REQ_CORDIC_WRITE,
+		LL_DMA_DIRECTION_MEMORY_TO_PERIPH,
+		LL_CORDIC_DMA_GetRegAddr(CORDIC, LL_CORDIC_DMA_REG_DATA_IN),
+		(uint32_t)angles_q31,
+		count);
+
+	LL_DMA_ClearFlag_TC5(CORDIC_DMA);
+	LL_DMA_EnableIT_TC(CORDIC_DMA, CORDIC_DMA_READ_CHANNEL);
+
+	LL_DMA_EnableChannel(CORDIC_DMA, CORDIC_DMA_READ_CHANNEL);
+	LL_DMA_EnableChannel(CORDIC_DMA, CORDIC_DMA_WRITE_CHANNEL);
+
+	LL_CORDIC_EnableDMAReq_RD(CORDIC);
+	LL_CORDIC_EnableDMAReq_WR(CORDIC);
+
+	return 0;
+}
+
+#endif /* CONFIG_OWNTECH_CORDIC_DRIVER_ENABLE_DMA */
+
+
+/**
+ *  Zephyr macro to automatically run above function
+ */
+
+static int _cordic_init()
+{
+	cordic_init();
+
+	return 0;
+}
+
+/* CORDIC is ready before the application uses it in the control path */
+SYS_INIT(_cordic_init,
+		 PRE_KERNEL_2,
+		 CONFIG_KERNEL_INIT_PRIORITY_DEVICE
+		);
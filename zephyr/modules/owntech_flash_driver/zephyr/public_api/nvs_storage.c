@@ -29,12 +29,16 @@
  *  Includes
  */
 
+/* Stdlib */
+#include <string.h>
+
 /* Zephyr */
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/fs/nvs.h>
 #include <zephyr/drivers/flash.h>
 #include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/crc.h>
 
 /* CMSIS */
 #include <arm_math.h>
@@ -48,6 +52,35 @@ static const uint16_t current_storage_version = 0x0001;
 static uint16_t storage_version_in_nvs = 0;
 static bool initialized = false;
 
+/* Sector number is in the upper half of NVS addresses */
+static const uint8_t nvs_sector_shift = 16;
+
+/* Versioned record header fields */
+static const uint8_t record_entries_count_offset = 2;
+static const uint8_t record_crc_offset = 4;
+
+static nvs_storage_stats_t stats = {0};
+
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+
+/** @brief Data item waiting to be written to flash */
+typedef struct
+{
+	bool     pending;
+	uint16_t data_id;
+	uint16_t data_size;
+	uint8_t  data[CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRY_SIZE];
+} cache_entry_t;
+
+static cache_entry_t write_cache[CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES];
+
+K_MUTEX_DEFINE(write_cache_mutex);
+
+static void _nvs_storage_flush_work_handler(struct k_work* work);
+K_WORK_DELAYABLE_DEFINE(flush_work, _nvs_storage_flush_work_handler);
+
+#endif /* CONFIG_OWNTECH_FLASH_WRITE_CACHE */
+
 /* Device-tree related macros */
 #define NVS_PARTITION storage_partition
 #define STORAGE_NODE  DT_NODE_BY_FIXED_PARTITION_LABEL(NVS_PARTITION)
@@ -60,6 +93,45 @@ static struct nvs_fs fs =
 };
 
 
+/**
+ * @brief PRIVATE FUNCTION - Write a data item to flash and update statistics.
+ *
+ * NVS does not write data identical to the last stored value of the item,
+ * in which case `0` is returned.
+ *
+ * @return Number of bytes written, `0` if the data was already in flash,
+ *         negative value on error.
+ */
+static int _nvs_storage_write(uint16_t data_id,
+							  const void* data,
+							  uint16_t data_size)
+{
+	uint32_t sector_before = fs.ate_wra >> nvs_sector_shift;
+
+	int rc = nvs_write(&fs, data_id, data, data_size);
+
+	uint32_t sector_after = fs.ate_wra >> nvs_sector_shift;
+
+	if (rc > 0)
+	{
+		stats.writes++;
+	}
+	else if ( (rc == 0) && (data_size > 0) )
+	{
+		stats.skipped_writes++;
+	}
+
+	/* Each time NVS moves to a new sector, the next one is garbage
+	 * collected then erased. */
+	if (sector_after != sector_before)
+	{
+		stats.garbage_collections +=
+			(sector_after + fs.sector_count - sector_before) % fs.sector_count;
+	}
+
+	return rc;
+}
+
 /**
  * @brief PRIVATE FUNCTION - Store the current NVS (Non-Volatile Storage) 
  *        version if needed.
@@ -90,9 +162,9 @@ static int8_t _nvs_storage_store_version()
 	{
 		/* No version in NVS: this is the first use of NVS,
 		 * store current version number. */
-		int rc = nvs_write(&fs, VERSION, &current_storage_version, 2);
+		int rc = _nvs_storage_write(VERSION, &current_storage_version, 2);
 
-		if (rc == 2)
+		if (rc >= 0)
 		{
 			storage_version_in_nvs = current_storage_version;
 			return 0;
@@ -110,6 +182,159 @@ static int8_t _nvs_storage_store_version()
 	}
 }
 
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+
+/**
+ * @brief PRIVATE FUNCTION - Find the pending cache entry of a data item.
+ *
+ * @return Pointer to the entry, `NULL` if the item is not pending.
+ *
+ * @note Must be called with the cache mutex locked.
+ */
+static cache_entry_t* _nvs_storage_cache_find(uint16_t data_id)
+{
+	for (uint8_t i = 0 ; i < CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES ; i++)
+	{
+		if ( (write_cache[i].pending == true) &&
+			 (write_cache[i].data_id == data_id) )
+		{
+			return &write_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Write all pending entries to flash.
+ *
+ * Entries that failed to be written stay pending.
+ *
+ * @return `0` if all entries were written, `-1` otherwise.
+ *
+ * @note Must be called with the cache mutex locked.
+ */
+static int8_t _nvs_storage_cache_flush()
+{
+	int8_t result = 0;
+
+	for (uint8_t i = 0 ; i < CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES ; i++)
+	{
+		if (write_cache[i].pending == false)
+			continue;
+
+		int rc = _nvs_storage_write(write_cache[i].data_id,
+									write_cache[i].data,
+									write_cache[i].data_size);
+		if (rc < 0)
+		{
+			result = -1;
+		}
+		else
+		{
+			write_cache[i].pending = false;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Put a data item in the cache.
+ *
+ * A pending value of the same item is replaced. If the cache is full,
+ * it is flushed first.
+ *
+ * @return `0` if the item is in cache, `-1` otherwise.
+ */
+static int8_t _nvs_storage_cache_store(uint16_t data_id,
+									   const void* data,
+									   uint16_t data_size)
+{
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+
+	cache_entry_t* entry = _nvs_storage_cache_find(data_id);
+
+	if (entry != NULL)
+	{
+		if ( (entry->data_size == data_size) &&
+			 (memcmp(entry->data, data, data_size) == 0) )
+		{
+			/* Same value already pending */
+			stats.skipped_writes++;
+			k_mutex_unlock(&write_cache_mutex);
+			return 0;
+		}
+
+		stats.coalesced_writes++;
+	}
+	else
+	{
+		for (uint8_t i = 0 ; i < CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES ; i++)
+		{
+			if (write_cache[i].pending == false)
+			{
+				entry = &write_cache[i];
+				break;
+			}
+		}
+
+		if ( (entry == NULL) && (_nvs_storage_cache_flush() == 0) )
+		{
+			entry = &write_cache[0];
+		}
+
+		if (entry == NULL)
+		{
+			k_mutex_unlock(&write_cache_mutex);
+			return -1;
+		}
+	}
+
+	memcpy(entry->data, data, data_size);
+	entry->data_id   = data_id;
+	entry->data_size = data_size;
+	entry->pending   = true;
+
+	k_mutex_unlock(&write_cache_mutex);
+
+	if (CONFIG_OWNTECH_FLASH_WRITE_CACHE_FLUSH_DELAY_MS > 0)
+	{
+		k_work_reschedule(&flush_work,
+						  K_MSEC(CONFIG_OWNTECH_FLASH_WRITE_CACHE_FLUSH_DELAY_MS));
+	}
+
+	return 0;
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Drop the pending value of a data item.
+ */
+static void _nvs_storage_cache_drop(uint16_t data_id)
+{
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+
+	cache_entry_t* entry = _nvs_storage_cache_find(data_id);
+	if (entry != NULL)
+	{
+		entry->pending = false;
+	}
+
+	k_mutex_unlock(&write_cache_mutex);
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Delayed flush of the cache.
+ */
+static void _nvs_storage_flush_work_handler(struct k_work* work)
+{
+	ARG_UNUSED(work);
+
+	nvs_storage_flush();
+}
+
+#endif /* CONFIG_OWNTECH_FLASH_WRITE_CACHE */
+
 /**
  * @brief PRIVATE FUNCTION - Initialize the NVS (Non-Volatile Storage) subsystem.
  *
@@ -194,9 +419,9 @@ static int8_t _nvs_storage_init()
 
 /* Public functions */
 
-int8_t nvs_storage_store_data(uint16_t data_id,
-							  const void* data,
-							  uint8_t data_size)
+int16_t nvs_storage_store_data(uint16_t data_id,
+							   const void* data,
+							   uint16_t data_size)
 {
 	if (initialized == false)
 	{
@@ -210,14 +435,30 @@ int8_t nvs_storage_store_data(uint16_t data_id,
 		return rc;
 	}
 
-	rc = nvs_write(&fs, data_id, data, data_size);
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	if (data_size <= CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRY_SIZE)
+	{
+		if (_nvs_storage_cache_store(data_id, data, data_size) == 0)
+		{
+			return data_size;
+		}
+	}
+	else
+	{
+		/* Written immediately, so an older pending value must not
+		 * overwrite it on next flush */
+		_nvs_storage_cache_drop(data_id);
+	}
+#endif
+
+	rc = _nvs_storage_write(data_id, data, data_size);
 
 	return rc;
 }
 
-int8_t nvs_storage_retrieve_data(uint16_t data_id,
-								 void* data_buffer,
-								 uint8_t data_buffer_size)
+int16_t nvs_storage_retrieve_data(uint16_t data_id,
+								  void* data_buffer,
+								  uint16_t data_buffer_size)
 {
 	if (initialized == false)
 	{
@@ -225,6 +466,30 @@ int8_t nvs_storage_retrieve_data(uint16_t data_id,
 		if (error != 0) return error;
 	}
 
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	/* Pending value is more recent than the one in flash */
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+
+	cache_entry_t* entry = _nvs_storage_cache_find(data_id);
+	if (entry != NULL)
+	{
+		int16_t size = entry->data_size;
+		if (size > data_buffer_size)
+		{
+			size = -1;
+		}
+		else
+		{
+			memcpy(data_buffer, entry->data, size);
+		}
+
+		k_mutex_unlock(&write_cache_mutex);
+		return size;
+	}
+
+	k_mutex_unlock(&write_cache_mutex);
+#endif
+
 	int rc = nvs_read(&fs, data_id, data_buffer, 1);
 
 	if (rc > 1) /* There is more than 1 byte of data */
@@ -249,7 +514,81 @@ int8_t nvs_storage_clear_all_stored_data()
 		if (error != 0) return 0;
 	}
 
-	return nvs_clear(&fs);
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	k_work_cancel_delayable(&flush_work);
+
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+	for (uint8_t i = 0 ; i < CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES ; i++)
+	{
+		write_cache[i].pending = false;
+	}
+	k_mutex_unlock(&write_cache_mutex);
+#endif
+
+	int rc = nvs_clear(&fs);
+
+	/* The version record has been erased with the rest of the data: it
+	 * must be written again before the next store. NVS also has to be
+	 * mounted again, as its write position is no longer valid. */
+	storage_version_in_nvs = 0;
+	initialized = false;
+
+	return rc;
+}
+
+int8_t nvs_storage_flush()
+{
+	if (initialized == false)
+	{
+		int8_t error = _nvs_storage_init();
+		if (error != 0) return -1;
+	}
+
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+	int8_t result = _nvs_storage_cache_flush();
+	k_mutex_unlock(&write_cache_mutex);
+
+	return result;
+#else
+	return 0;
+#endif
+}
+
+int8_t nvs_storage_get_stats(nvs_storage_stats_t* storage_stats)
+{
+	if (initialized == false)
+	{
+		int8_t error = _nvs_storage_init();
+		if (error != 0) return -1;
+	}
+
+	ssize_t free_space = nvs_calc_free_space(&fs);
+	if (free_space < 0)
+	{
+		return -1;
+	}
+
+	*storage_stats = stats;
+
+	storage_stats->free_space   = free_space;
+	storage_stats->sector_count = fs.sector_count;
+
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	storage_stats->pending_writes = 0;
+
+	k_mutex_lock(&write_cache_mutex, K_FOREVER);
+	for (uint8_t i = 0 ; i < CONFIG_OWNTECH_FLASH_WRITE_CACHE_ENTRIES ; i++)
+	{
+		if (write_cache[i].pending == true)
+		{
+			storage_stats->pending_writes++;
+		}
+	}
+	k_mutex_unlock(&write_cache_mutex);
+#endif
+
+	return 0;
 }
 
 uint16_t nvs_storage_get_current_version()
@@ -273,3 +612,50 @@ uint16_t nvs_storage_get_version_in_nvs()
 
 	return storage_version_in_nvs;
 }
+
+void nvs_storage_record_seal(uint8_t* buffer,
+							 uint16_t size,
+							 uint16_t schema_version,
+							 uint8_t entries_count)
+{
+	memcpy(&buffer[0], &schema_version, 2);
+	buffer[record_entries_count_offset] = entries_count;
+	buffer[3] = 0;
+	memset(&buffer[record_crc_offset], 0, 4);
+
+	uint32_t crc = crc32_ieee(buffer, size);
+	memcpy(&buffer[record_crc_offset], &crc, 4);
+}
+
+int8_t nvs_storage_record_check(uint8_t* buffer,
+								int16_t size,
+								uint16_t schema_version)
+{
+	if (size < (int16_t)NVS_STORAGE_RECORD_HEADER_SIZE)
+	{
+		return -1;
+	}
+
+	uint16_t stored_version;
+	memcpy(&stored_version, &buffer[0], 2);
+	if (stored_version != schema_version)
+	{
+		return -2;
+	}
+
+	/* CRC is computed with its own field set to 0 */
+	uint32_t stored_crc;
+	memcpy(&stored_crc, &buffer[record_crc_offset], 4);
+	memset(&buffer[record_crc_offset], 0, 4);
+
+	uint32_t crc = crc32_ieee(buffer, size);
+
+	memcpy(&buffer[record_crc_offset], &stored_crc, 4);
+
+	return (crc == stored_crc) ? 0 : -3;
+}
+
+uint8_t nvs_storage_record_get_entries_count(const uint8_t* buffer)
+{
+	return buffer[record_entries_count_offset];
+}
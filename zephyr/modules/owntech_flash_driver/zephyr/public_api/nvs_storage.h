@@ -46,6 +46,10 @@ extern "C" {
  * 
  * - `MEASURE_THRESHOLD` = 0x0300
  * 
+ * - `CALIBRATION_PROFILE` = 0x0400
+ * 
+ * - `APPLICATION_PARAMETERS` = 0x0500
+ * 
  * 
  * @note Must be on the upper half of the 2-bytes value, hence end with 00
  */
@@ -54,8 +58,43 @@ typedef enum
 	VERSION          = 0x0100,
 	ADC_CALIBRATION  = 0x0200,
 	MEASURE_THRESHOLD = 0x0300,
+	CALIBRATION_PROFILE = 0x0400,
+	APPLICATION_PARAMETERS = 0x0500,
 }nvs_category_t;
 
+/**
+ * @brief Flash usage statistics, counted since boot.
+ *
+ * - `writes`: data items actually written to flash
+ *
+ * - `skipped_writes`: stores not written because data was unchanged
+ *
+ * - `coalesced_writes`: pending values replaced by a newer one before
+ *   being written
+ *
+ * - `pending_writes`: data items in cache, not yet written to flash
+ *
+ * - `garbage_collections`: sectors garbage collected and erased
+ *
+ * - `free_space`: bytes that can be written before next garbage collection
+ *
+ * - `sector_count`: number of sectors of the NVS partition
+ */
+typedef struct
+{
+	uint32_t writes;
+	uint32_t skipped_writes;
+	uint32_t coalesced_writes;
+	uint32_t pending_writes;
+	uint32_t garbage_collections;
+	uint32_t free_space;
+	uint8_t  sector_count;
+} nvs_storage_stats_t;
+
+/** @brief Size of the header of a versioned record, see
+ *         `nvs_storage_record_seal()` */
+#define NVS_STORAGE_RECORD_HEADER_SIZE (8U)
+
 /**
  * @brief Store a data item in non-volatile storage (NVS).
  *
@@ -63,15 +102,20 @@ typedef enum
  * 
  * If the data already exists, it is overwritten. Useful for persisting configuration.
  *
+ * When the write cache is enabled (`CONFIG_OWNTECH_FLASH_WRITE_CACHE`),
+ * data is written to flash on the next flush and this function returns
+ * immediately. Storing data identical to the current value does not write
+ * to flash.
+ *
  * @param data_id     Identifier for the data item.
  * @param data        Pointer to the data to be stored.
  * @param data_size   Size of the data in bytes.
  *
- * @return 0 on success, negative value on error.
+ * @return Number of bytes written on success, negative value on error.
  */
-int8_t nvs_storage_store_data(uint16_t data_id,
-							  const void* data,
-							  uint8_t data_size);
+int16_t nvs_storage_store_data(uint16_t data_id,
+							   const void* data,
+							   uint16_t data_size);
 
 /**
  * @brief Retrieve a data item from non-volatile storage (NVS).
@@ -85,9 +129,9 @@ int8_t nvs_storage_store_data(uint16_t data_id,
  *
  * @return Number of bytes read on success, negative value on error.
  */							  
-int8_t nvs_storage_retrieve_data(uint16_t data_id,
-								 void* data_buffer,
-								 uint8_t data_buffer_size);
+int16_t nvs_storage_retrieve_data(uint16_t data_id,
+								  void* data_buffer,
+								  uint16_t data_buffer_size);
 
 /**
  * @brief Clear all data stored in the NVS partition.
@@ -98,6 +142,25 @@ int8_t nvs_storage_retrieve_data(uint16_t data_id,
  */								 
 int8_t nvs_storage_clear_all_stored_data();
 
+/**
+ * @brief Write all data pending in the write cache to flash.
+ *
+ * Call this before a reset or power down that must not lose stored data.
+ * Does nothing when the write cache is disabled.
+ *
+ * @return 0 on success, -1 if some data could not be written.
+ */
+int8_t nvs_storage_flush();
+
+/**
+ * @brief Get flash usage statistics.
+ *
+ * @param storage_stats Structure filled with current statistics.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int8_t nvs_storage_get_stats(nvs_storage_stats_t* storage_stats);
+
 /**
  * @brief Get the current in-code version of the NVS layout.
  *
@@ -118,6 +181,58 @@ uint16_t nvs_storage_get_current_version();
  */
 uint16_t nvs_storage_get_version_in_nvs();
 
+/**
+ * @brief Seal a versioned record before storing it.
+ *
+ * A versioned record starts with an `NVS_STORAGE_RECORD_HEADER_SIZE`
+ * bytes header, followed by entries whose layout is up to the user:
+ *
+ * - 2 bytes schema version
+ *
+ * - 1 byte number of entries
+ *
+ * - 1 byte reserved
+ *
+ * - 4 bytes CRC32 of the whole record, computed with this field set to 0
+ *
+ * This function writes the header, entries must already be in the buffer.
+ *
+ * @param buffer         Record, entries starting at
+ *                       `NVS_STORAGE_RECORD_HEADER_SIZE`
+ * @param size           Size of the whole record in bytes
+ * @param schema_version Version of the entries layout
+ * @param entries_count  Number of entries in the record
+ */
+void nvs_storage_record_seal(uint8_t* buffer,
+							 uint16_t size,
+							 uint16_t schema_version,
+							 uint8_t entries_count);
+
+/**
+ * @brief Check the header of a versioned record retrieved from NVS.
+ *
+ * @param buffer         Record, see `nvs_storage_record_seal()`
+ * @param size           Size of the record as returned by
+ *                       `nvs_storage_retrieve_data()`, can be negative.
+ * @param schema_version Expected version of the entries layout
+ *
+ * @return `0` if the record is valid, `-1` if it is smaller than the
+ *         header, `-2` if it was written with another schema version,
+ *         `-3` if its CRC does not match.
+ */
+int8_t nvs_storage_record_check(uint8_t* buffer,
+								int16_t size,
+								uint16_t schema_version);
+
+/**
+ * @brief Get the number of entries of a versioned record.
+ *
+ * @param buffer Record, see `nvs_storage_record_seal()`
+ *
+ * @return Number of entries written in the record header.
+ */
+uint8_t nvs_storage_record_get_entries_count(const uint8_t* buffer);
+
 
 #ifdef __cplusplus
 }
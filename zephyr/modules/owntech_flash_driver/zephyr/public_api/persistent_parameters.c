@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+
+/**
+ *  Includes
+ */
+
+/* Stdlib */
+#include <string.h>
+
+/* Zephyr */
+#include <zephyr/kernel.h>
+
+/* Other modules */
+#include "nvs_storage.h"
+
+/* Current file header */
+#include "persistent_parameters.h"
+
+
+/**
+ * Group record: NVS storage versioned record, whose entries are:
+ * - 1 byte identifier
+ * - 1 byte type
+ * - 4 bytes value, zero-padded for smaller types.
+ */
+static const uint16_t PARAMETERS_SCHEMA_VERSION = 0x0001;
+static const uint8_t  PARAMETERS_HEADER_SIZE    = NVS_STORAGE_RECORD_HEADER_SIZE;
+static const uint8_t  PARAMETERS_ENTRY_SIZE     = 6;
+
+#define PARAMETERS_RECORD_MAX_SIZE (NVS_STORAGE_RECORD_HEADER_SIZE + \
+									6 * CONFIG_OWNTECH_FLASH_PARAMETERS_MAX_COUNT)
+
+/** @brief Registered parameter */
+typedef struct
+{
+	uint8_t          group;
+	uint8_t          id;
+	parameter_type_t type;
+	void*            value;
+	uint8_t          default_value[4];
+} parameter_entry_t;
+
+static parameter_entry_t parameters[CONFIG_OWNTECH_FLASH_PARAMETERS_MAX_COUNT];
+static uint8_t parameters_count = 0;
+
+
+/* Private API */
+
+/**
+ * Size of a type in bytes, 0 for unknown types.
+ */
+static uint8_t _persistent_parameters_get_type_size(uint8_t type)
+{
+	switch (type)
+	{
+		case PARAMETER_UINT8:
+		case PARAMETER_INT8:
+			return 1;
+		case PARAMETER_UINT16:
+		case PARAMETER_INT16:
+			return 2;
+		case PARAMETER_UINT32:
+		case PARAMETER_INT32:
+		case PARAMETER_FLOAT32:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Returns true if a group was already handled by a previous entry.
+ */
+static bool _persistent_parameters_group_seen(uint8_t index)
+{
+	for (uint8_t i = 0 ; i < index ; i++)
+	{
+		if (parameters[i].group == parameters[index].group)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Apply the values of a group record to registered variables.
+ */
+static int8_t _persistent_parameters_apply(uint8_t group,
+										   uint8_t* buffer,
+										   int16_t size)
+{
+	if (nvs_storage_record_check(buffer,
+								 size,
+								 PARAMETERS_SCHEMA_VERSION) != 0)
+	{
+		return -1;
+	}
+
+	uint8_t entries_count = nvs_storage_record_get_entries_count(buffer);
+
+	if (size != PARAMETERS_HEADER_SIZE + PARAMETERS_ENTRY_SIZE * entries_count)
+	{
+		return -1;
+	}
+
+	for (uint8_t i = 0 ; i < entries_count ; i++)
+	{
+		uint8_t* entry = &buffer[PARAMETERS_HEADER_SIZE +
+								 PARAMETERS_ENTRY_SIZE * i];
+
+		for (uint8_t j = 0 ; j < parameters_count ; j++)
+		{
+			if ( (parameters[j].group == group) &&
+				 (parameters[j].id == entry[0]) &&
+				 (parameters[j].type == entry[1]) )
+			{
+				memcpy(parameters[j].value,
+					   &entry[2],
+					   _persistent_parameters_get_type_size(entry[1]));
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+/* Public API */
+
+int8_t persistent_parameters_register(uint8_t group,
+									  uint8_t id,
+									  parameter_type_t type,
+									  void* value)
+{
+	uint8_t type_size = _persistent_parameters_get_type_size(type);
+
+	if ( (value == NULL) || (type_size == 0) ||
+		 (parameters_count >= CONFIG_OWNTECH_FLASH_PARAMETERS_MAX_COUNT) )
+	{
+		return -1;
+	}
+
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		if ( (parameters[i].group == group) && (parameters[i].id == id) )
+		{
+			return -1;
+		}
+	}
+
+	parameter_entry_t* parameter = &parameters[parameters_count];
+
+	parameter->group = group;
+	parameter->id    = id;
+	parameter->type  = type;
+	parameter->value = value;
+	memset(parameter->default_value, 0, 4);
+	memcpy(parameter->default_value, value, type_size);
+
+	parameters_count++;
+
+	return 0;
+}
+
+int8_t persistent_parameters_load()
+{
+	uint8_t buffer[PARAMETERS_RECORD_MAX_SIZE];
+	int8_t groups_found = 0;
+	int8_t ret = 0;
+
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		if (_persistent_parameters_group_seen(i) == true)
+		{
+			continue;
+		}
+
+		uint8_t group = parameters[i].group;
+
+		int16_t size = nvs_storage_retrieve_data(APPLICATION_PARAMETERS | group,
+												 buffer,
+												 sizeof(buffer));
+
+		if (size < PARAMETERS_HEADER_SIZE)
+		{
+			/* Group never stored: default values are used */
+			continue;
+		}
+
+		if (_persistent_parameters_apply(group, buffer, size) == 0)
+		{
+			groups_found++;
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+
+	return (ret < 0) ? ret : groups_found;
+}
+
+int8_t persistent_parameters_save()
+{
+	uint8_t buffer[PARAMETERS_RECORD_MAX_SIZE];
+	int8_t ret = 0;
+
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		if (_persistent_parameters_group_seen(i) == true)
+		{
+			continue;
+		}
+
+		uint8_t group = parameters[i].group;
+		uint16_t size = PARAMETERS_HEADER_SIZE;
+		uint8_t entries_count = 0;
+
+		for (uint8_t j = i ; j < parameters_count ; j++)
+		{
+			if (parameters[j].group != group)
+			{
+				continue;
+			}
+
+			uint8_t* entry = &buffer[size];
+
+			entry[0] = parameters[j].id;
+			entry[1] = parameters[j].type;
+			memset(&entry[2], 0, 4);
+			memcpy(&entry[2],
+				   parameters[j].value,
+				   _persistent_parameters_get_type_size(parameters[j].type));
+
+			size += PARAMETERS_ENTRY_SIZE;
+			entries_count++;
+		}
+
+		nvs_storage_record_seal(buffer,
+								size,
+								PARAMETERS_SCHEMA_VERSION,
+								entries_count);
+
+		/* Unchanged groups are not written again by NVS storage */
+		if (nvs_storage_store_data(APPLICATION_PARAMETERS | group,
+								   buffer,
+								   size) < 0)
+		{
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+void persistent_parameters_restore_defaults()
+{
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		memcpy(parameters[i].value,
+			   parameters[i].default_value,
+			   _persistent_parameters_get_type_size(parameters[i].type));
+	}
+}
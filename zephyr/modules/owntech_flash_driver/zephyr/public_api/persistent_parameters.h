@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/**
+ * @brief Persistent application parameters.
+ *
+ * Application variables are registered with a group and an identifier.
+ * The value a variable has when it is registered is its default value.
+ *
+ * All registered variables are loaded at once from NVS with
+ * `persistent_parameters_load()`, usually at the end of the setup routine.
+ * Variables with no valid stored value keep their default value.
+ *
+ * `persistent_parameters_save()` stores each group as a single NVS record
+ * under the `APPLICATION_PARAMETERS` category: a group is written at once,
+ * and only if one of its values changed.
+ */
+
+#ifndef PERSISTENT_PARAMETERS_H_
+#define PERSISTENT_PARAMETERS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of a persistent parameter.
+ *
+ * All types are at most 4 bytes long.
+ */
+typedef enum
+{
+	PARAMETER_UINT8   = 1,
+	PARAMETER_INT8    = 2,
+	PARAMETER_UINT16  = 3,
+	PARAMETER_INT16   = 4,
+	PARAMETER_UINT32  = 5,
+	PARAMETER_INT32   = 6,
+	PARAMETER_FLOAT32 = 7,
+} parameter_type_t;
+
+/**
+ * @brief Register a variable as a persistent parameter.
+ *
+ * @param group Group of the parameter, from `0` to `255`. Parameters of a
+ *              group are stored together.
+ * @param id    Identifier of the parameter, unique in its group.
+ * @param type  Type of the variable.
+ * @param value Pointer to the variable. Its current value becomes
+ *              the default value of the parameter.
+ *
+ * @return `0` on success, `-1` if parameters are invalid, the identifier
+ *         is already used in this group or the registry is full
+ *         (see `CONFIG_OWNTECH_FLASH_PARAMETERS_MAX_COUNT`).
+ */
+int8_t persistent_parameters_register(uint8_t group,
+									  uint8_t id,
+									  parameter_type_t type,
+									  void* value);
+
+/**
+ * @brief Set all registered variables to their stored value.
+ *
+ * Each group is read once. Variables missing from their group record,
+ * or stored with another type, keep their current value.
+ *
+ * @return Number of groups found in NVS, `-1` if a group record
+ *         was found but is corrupted.
+ */
+int8_t persistent_parameters_load();
+
+/**
+ * @brief Store the current value of all registered variables.
+ *
+ * Groups are stored through the NVS write cache, use `nvs_storage_flush()`
+ * to write them to flash immediately.
+ *
+ * @return `0` on success, `-1` if a group could not be stored.
+ */
+int8_t persistent_parameters_save();
+
+/**
+ * @brief Set all registered variables back to their default value.
+ *
+ * Stored values are not changed until the next save.
+ */
+void persistent_parameters_restore_defaults();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENT_PARAMETERS_H_ */
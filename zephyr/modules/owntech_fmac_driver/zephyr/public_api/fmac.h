@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/**
+ * @brief FMAC (filter math accelerator) driver.
+ *
+ * The FMAC runs one FIR or IIR (direct form 1) filter on q1.15 samples.
+ * Coefficients are loaded once, then the filter is started and keeps
+ * running: blocks of samples are fed to the accelerator and results
+ * retrieved by DMA 2 channels 6 (write) and 7 (read), the filter history
+ * staying in the FMAC memory from one block to the next.
+ *
+ * Several signals can be filtered by the same stream when their samples
+ * are interleaved, always in the same order: coefficients are then spread
+ * so that each output only depends on samples of the same signal.
+ */
+
+#ifndef FMAC_H_
+#define FMAC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of the FMAC local memory, in 16-bit words */
+#define FMAC_MEMORY_SIZE (256U)
+
+/** @brief Maximum number of feed-forward coefficients, once spread */
+#define FMAC_B_COEFFS_MAX (64U)
+
+/** @brief Maximum number of feedback coefficients, once spread */
+#define FMAC_A_COEFFS_MAX (63U)
+
+/**
+ * @brief Called when a block has been filtered.
+ *
+ * @param status `0` if the output block holds the filtered samples,
+ *               `-1` if filtering was aborted by `fmac_stop()`.
+ */
+typedef void (*fmac_callback_t)(int8_t status);
+
+/**
+ * @brief Load a FIR filter.
+ *
+ * `y[n] = 2^gain * sum(b[k] * x[n-k])`
+ *
+ * A running filter is stopped.
+ *
+ * @param b       Array of `b_count` coefficients in q1.15 format
+ * @param b_count Number of coefficients, between 1 and `FMAC_B_COEFFS_MAX`
+ * @param gain    Output gain as a power of 2, between 0 and 7
+ *
+ * @return `0` if the filter is loaded, `-1` if parameters are invalid.
+ */
+int8_t fmac_load_fir(const int16_t* b, uint8_t b_count, uint8_t gain);
+
+/**
+ * @brief Load an IIR filter (direct form 1).
+ *
+ * `y[n] = 2^gain * (sum(b[k] * x[n-k]) + sum(a[k] * y[n-k-1]))`
+ *
+ * A running filter is stopped.
+ *
+ * @param b       Array of `b_count` feed-forward coefficients in q1.15
+ * @param b_count Number of feed-forward coefficients,
+ *                between 1 and `FMAC_B_COEFFS_MAX`
+ * @param a       Array of `a_count` feedback coefficients in q1.15.
+ *                Note the sign: they are added, not subtracted.
+ * @param a_count Number of feedback coefficients,
+ *                between 1 and `FMAC_A_COEFFS_MAX`
+ * @param gain    Output gain as a power of 2, between 0 and 7
+ *
+ * @return `0` if the filter is loaded, `-1` if parameters are invalid.
+ */
+int8_t fmac_load_iir(const int16_t* b,
+					 uint8_t b_count,
+					 const int16_t* a,
+					 uint8_t a_count,
+					 uint8_t gain);
+
+/**
+ * @brief Start the loaded filter on a stream of interleaved signals.
+ *
+ *        The filter history is cleared, as for signals that were always 0.
+ *        Coefficients are spread by `signals_count`, so that spread counts
+ *        `signals_count*(b_count-1)+1` and `signals_count*a_count` must
+ *        not exceed `FMAC_B_COEFFS_MAX` and `FMAC_A_COEFFS_MAX`.
+ *
+ * @param signals_count Number of interleaved signals, 1 for a single signal
+ *
+ * @return `0` if the filter is started, `-1` if no filter is loaded or
+ *         spread coefficients do not fit.
+ */
+int8_t fmac_start(uint8_t signals_count);
+
+/**
+ * @brief Stop the filter and reset the FMAC, coefficients are kept.
+ *        A block being filtered is aborted.
+ */
+void fmac_stop();
+
+/**
+ * @brief Returns `true` if a filter is loaded.
+ */
+bool fmac_is_loaded();
+
+/**
+ * @brief Returns `true` if the filter is started.
+ */
+bool fmac_is_started();
+
+/**
+ * @brief Returns `true` if a block is being filtered.
+ */
+bool fmac_dma_is_busy();
+
+/**
+ * @brief Filter a block of samples in the background.
+ *
+ *        The block goes on from the previous one: the filter history is
+ *        the one left by the previous block in the FMAC memory. Each input
+ *        sample produces one output sample.
+ *
+ * @param input    Array of `count` samples in q1.15 format
+ * @param output   Array receiving `count` filtered samples in q1.15 format
+ * @param count    Number of samples
+ * @param callback Function called from the DMA interrupt when the
+ *                 block is done, can be NULL.
+ *
+ * @return `0` if filtering started, `-1` if the filter is not started,
+ *         a block is already being filtered or count is 0.
+ *
+ * @warning All arrays must remain valid until the callback is called.
+ */
+int8_t fmac_dma_filter(const int16_t* input,
+					   int16_t* output,
+					   uint16_t count,
+					   fmac_callback_t callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMAC_H_ */
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/* Stdlib */
+#include <string.h>
+
+/* Zephyr */
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+
+/* STM32 LL */
+#include <stm32_ll_bus.h>
+#include <stm32_ll_fmac.h>
+#include <stm32_ll_dma.h>
+#include <stm32_ll_dmamux.h>
+
+/* Current file header */
+#include "fmac.h"
+
+
+/**
+ *  Local variables
+ */
+
+/**
+ * DMA 1 channels are used by the ADCs, RS485 and DAC, and DMA 2
+ * channels 1 to 5 by USART 1, the LED and the CORDIC: DMA 2 is
+ * driven directly with LL drivers.
+ */
+#define FMAC_DMA               DMA2
+#define FMAC_DMA_WRITE_CHANNEL LL_DMA_CHANNEL_6
+#define FMAC_DMA_READ_CHANNEL  LL_DMA_CHANNEL_7
+
+/* Free space kept in input and output buffers after the filter history */
+static const uint8_t FMAC_BUFFER_HEADROOM = 2;
+
+/* Loaded filter, coefficients are spread when the filter is started */
+static bool     fmac_loaded   = false;
+static uint32_t fmac_function = 0;
+static int16_t  fmac_b[FMAC_B_COEFFS_MAX];
+static int16_t  fmac_a[FMAC_A_COEFFS_MAX];
+static uint8_t  fmac_b_count  = 0;
+static uint8_t  fmac_a_count  = 0;
+static uint8_t  fmac_gain     = 0;
+
+/* Running filter */
+static volatile bool fmac_started = false;
+
+/* Block being filtered */
+static volatile bool   dma_busy = false;
+static fmac_callback_t dma_user_callback = NULL;
+
+/* Private API */
+
+/**
+ * Reset clears the start bit, buffers pointers and flags,
+ * while buffers configuration and memory content are kept.
+ */
+static void _fmac_reset()
+{
+	LL_FMAC_EnableReset(FMAC);
+	while (LL_FMAC_IsEnabledReset(FMAC))
+	{
+	}
+}
+
+/**
+ * Write zeros to the FMAC memory using a load function.
+ */
+static void _fmac_load_zeros(uint32_t load_function, uint8_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	LL_FMAC_ConfigFunc(FMAC, 1, load_function, count, 0, 0);
+
+	for (uint8_t i = 0 ; i < count ; i++)
+	{
+		LL_FMAC_WriteData(FMAC, 0);
+	}
+}
+
+/**
+ * Stop DMA transfers of the current block.
+ * Returns the callback of the block, if any.
+ */
+static fmac_callback_t _fmac_dma_release()
+{
+	LL_DMA_DisableChannel(FMAC_DMA, FMAC_DMA_WRITE_CHANNEL);
+	LL_DMA_DisableChannel(FMAC_DMA, FMAC_DMA_READ_CHANNEL);
+
+	if (dma_busy == false)
+	{
+		return NULL;
+	}
+
+	dma_busy = false;
+
+	return dma_user_callback;
+}
+
+/**
+ * DMA interrupt
+ * Called when the read channel has retrieved all results.
+ */
+static void _fmac_dma_callback(const void* arg)
+{
+	ARG_UNUSED(arg);
+
+	if (LL_DMA_IsActiveFlag_TC7(FMAC_DMA) == 0)
+	{
+		return;
+	}
+
+	LL_DMA_ClearFlag_TC7(FMAC_DMA);
+
+	fmac_callback_t callback = _fmac_dma_release();
+
+	if (callback != NULL)
+	{
+		callback(0);
+	}
+}
+
+/**
+ * Configure one DMA channel for 16-bit transfers between
+ * the FMAC and memory. Memory address and length are set
+ * by each block.
+ */
+static void _fmac_dma_configure_channel(uint32_t channel,
+										uint32_t request,
+										uint32_t direction,
+										uint32_t peripheral_address)
+{
+	LL_DMA_InitTypeDef DMA_InitStruct = {0};
+
+	DMA_InitStruct.Direction = direction;
+	DMA_InitStruct.PeriphOrM2MSrcAddress = peripheral_address;
+	DMA_InitStruct.Mode = LL_DMA_MODE_NORMAL;
+	DMA_InitStruct.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_HALFWORD;
+	DMA_InitStruct.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_HALFWORD;
+	DMA_InitStruct.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+	DMA_InitStruct.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+	DMA_InitStruct.PeriphRequest = request;
+	DMA_InitStruct.Priority = LL_DMA_PRIORITY_LOW;
+
+	LL_DMA_DisableChannel(FMAC_DMA, channel);
+	LL_DMA_Init(FMAC_DMA, channel, &DMA_InitStruct);
+}
+
+/**
+ * Keep coefficients of a filter, which is laid out
+ * in the FMAC memory when started.
+ */
+static int8_t _fmac_configure(uint32_t function,
+							  const int16_t* b,
+							  uint8_t b_count,
+							  const int16_t* a,
+							  uint8_t a_count,
+							  uint8_t gain)
+{
+	if ( (b == NULL) || (b_count == 0) || (b_count > FMAC_B_COEFFS_MAX) ||
+		 (a_count > FMAC_A_COEFFS_MAX) || (gain > 7) )
+	{
+		return -1;
+	}
+
+	fmac_stop();
+
+	memcpy(fmac_b, b, b_count * sizeof(int16_t));
+	if (a_count > 0)
+	{
+		memcpy(fmac_a, a, a_count * sizeof(int16_t));
+	}
+
+	fmac_function = function;
+	fmac_b_count  = b_count;
+	fmac_a_count  = a_count;
+	fmac_gain     = gain;
+	fmac_loaded   = true;
+
+	return 0;
+}
+
+/* Public API */
+
+int8_t fmac_load_fir(const int16_t* b, uint8_t b_count, uint8_t gain)
+{
+	return _fmac_configure(LL_FMAC_FUNC_CONVO_FIR, b, b_count, NULL, 0, gain);
+}
+
+int8_t fmac_load_iir(const int16_t* b,
+					 uint8_t b_count,
+					 const int16_t* a,
+					 uint8_t a_count,
+					 uint8_t gain)
+{
+	if ( (a == NULL) || (a_count == 0) )
+	{
+		return -1;
+	}
+
+	return _fmac_configure(LL_FMAC_FUNC_IIR_DIRECT_FORM_1,
+						   b, b_count,
+						   a, a_count,
+						   gain);
+}
+
+int8_t fmac_start(uint8_t signals_count)
+{
+	if ( (fmac_loaded == false) || (signals_count == 0) )
+	{
+		return -1;
+	}
+
+	/* Spread coefficients: x[n-k] becomes x[n-k*signals_count] */
+	uint16_t b_count = signals_count * (fmac_b_count - 1) + 1;
+	uint16_t a_count = signals_count * fmac_a_count;
+
+	if ( (b_count > FMAC_B_COEFFS_MAX) || (a_count > FMAC_A_COEFFS_MAX) )
+	{
+		return -1;
+	}
+
+	/* Coefficients, then input buffer, then output buffer */
+	uint16_t x2_size = b_count + a_count;
+	uint16_t x1_base = x2_size;
+	uint16_t x1_size = b_count + FMAC_BUFFER_HEADROOM;
+	uint16_t y_base  = x1_base + x1_size;
+	uint16_t y_size  = a_count + FMAC_BUFFER_HEADROOM;
+
+	if (y_base + y_size > FMAC_MEMORY_SIZE)
+	{
+		return -1;
+	}
+
+	fmac_stop();
+
+	LL_FMAC_ConfigX2(FMAC, 0, x2_size);
+	LL_FMAC_ConfigX1(FMAC, LL_FMAC_WM_0_THRESHOLD_1, x1_base, x1_size);
+	LL_FMAC_ConfigY(FMAC, LL_FMAC_WM_0_THRESHOLD_1, y_base, y_size);
+
+	/* Feed-forward then feedback coefficients, zeros in between */
+	LL_FMAC_ConfigFunc(FMAC, 1, LL_FMAC_FUNC_LOAD_X2, b_count, a_count, 0);
+	for (uint16_t i = 0 ; i < b_count ; i++)
+	{
+		LL_FMAC_WriteData(FMAC, ((i % signals_count) == 0) ?
+								(uint16_t)fmac_b[i / signals_count] : 0);
+	}
+	for (uint16_t i = 0 ; i < a_count ; i++)
+	{
+		/* a[k] weights y[n-k-1] */
+		LL_FMAC_WriteData(FMAC, (((i + 1) % signals_count) == 0) ?
+								(uint16_t)fmac_a[(i + 1) / signals_count - 1] :
+								0);
+	}
+
+	/* Clear the history: each input then produces one output */
+	_fmac_load_zeros(LL_FMAC_FUNC_LOAD_X1, b_count - 1);
+	_fmac_load_zeros(LL_FMAC_FUNC_LOAD_Y,  a_count);
+
+	_fmac_dma_configure_channel(FMAC_DMA_READ_CHANNEL,
+								LL_DMAMUX_REQ_FMAC_READ,
+								LL_DMA_DIRECTION_PERIPH_TO_MEMORY,
+								(uint32_t)&FMAC->RDATA);
+
+	_fmac_dma_configure_channel(FMAC_DMA_WRITE_CHANNEL,
+								LL_DMAMUX_REQ_FMAC_WRITE,
+								LL_DMA_DIRECTION_MEMORY_TO_PERIPH,
+								(uint32_t)&FMAC->WDATA);
+
+	LL_DMA_EnableIT_TC(FMAC_DMA, FMAC_DMA_READ_CHANNEL);
+
+	/* Requests are only served while a block is being filtered */
+	LL_FMAC_EnableDMAReq_Read(FMAC);
+	LL_FMAC_EnableDMAReq_Write(FMAC);
+
+	LL_FMAC_ConfigFunc(FMAC, 1,
+					   fmac_function,
+					   b_count,
+					   a_count,
+					   fmac_gain);
+
+	fmac_started = true;
+
+	return 0;
+}
+
+void fmac_stop()
+{
+	unsigned int key = irq_lock();
+
+	fmac_started = false;
+
+	LL_FMAC_DisableDMAReq_Write(FMAC);
+	LL_FMAC_DisableDMAReq_Read(FMAC);
+
+	fmac_callback_t callback = _fmac_dma_release();
+	_fmac_reset();
+
+	irq_unlock(key);
+
+	if (callback != NULL)
+	{
+		callback(-1);
+	}
+}
+
+bool fmac_is_loaded()
+{
+	return fmac_loaded;
+}
+
+bool fmac_is_started()
+{
+	return fmac_started;
+}
+
+bool fmac_dma_is_busy()
+{
+	return dma_busy;
+}
+
+int8_t fmac_dma_filter(const int16_t* input,
+					   int16_t* output,
+					   uint16_t count,
+					   fmac_callback_t callback)
+{
+	if ( (input == NULL) || (output == NULL) || (count == 0) )
+	{
+		return -1;
+	}
+
+	unsigned int key = irq_lock();
+
+	if ( (fmac_started == false) || (dma_busy == true) )
+	{
+		irq_unlock(key);
+		return -1;
+	}
+
+	dma_busy          = true;
+	dma_user_callback = callback;
+
+	/* The filter keeps running: only point the channels to the block */
+	LL_DMA_SetMemoryAddress(FMAC_DMA, FMAC_DMA_READ_CHANNEL,
+							(uint32_t)output);
+	LL_DMA_SetDataLength(FMAC_DMA, FMAC_DMA_READ_CHANNEL, count);
+
+	LL_DMA_SetMemoryAddress(FMAC_DMA, FMAC_DMA_WRITE_CHANNEL,
+							(uint32_t)input);
+	LL_DMA_SetDataLength(FMAC_DMA, FMAC_DMA_WRITE_CHANNEL, count);
+
+	LL_DMA_ClearFlag_TC7(FMAC_DMA);
+
+	/* Results are read first so that no result is missed */
+	LL_DMA_EnableChannel(FMAC_DMA, FMAC_DMA_READ_CHANNEL);
+	LL_DMA_EnableChannel(FMAC_DMA, FMAC_DMA_WRITE_CHANNEL);
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+
+/**
+ *  Zephyr macro to automatically run above function
+ */
+
+static int _fmac_init()
+{
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_FMAC);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMAMUX1);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+	_fmac_reset();
+
+	IRQ_CONNECT(DMA2_Channel7_IRQn, 0, _fmac_dma_callback, NULL, 0);
+	irq_enable(DMA2_Channel7_IRQn);
+
+	return 0;
+}
+
+SYS_INIT(_fmac_init,
+		 PRE_KERNEL_2,
+		 CONFIG_KERNEL_INIT_PRIORITY_DEVICE
+		);
@@ -145,6 +145,15 @@ void hrtim_out_dis(hrtim_tu_number_t tu_number);
  */
 void hrtim_out_en(hrtim_tu_number_t tu_number);
 
+/**
+ * @brief   Returns whether an output of a given timing unit is enabled
+ *
+ * @param[in] tu_number        Timing unit number:
+ *                  `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
+ * @return `true` if at least one of its two outputs is enabled
+ */
+bool hrtim_out_is_enabled(hrtim_tu_number_t tu_number);
+
 /**
  * @brief   Enables only one output of a given timing unit
  *
@@ -334,6 +343,34 @@ void hrtim_dt_set(hrtim_tu_number_t tu_number,
                   uint16_t rise_ns,
                   uint16_t fall_ns);
 
+/**
+ * @brief   Computes the dead time register value of a timing unit for given
+ *          rising and falling dead times, without writing it.
+ *
+ *          The value is computed with the dead time prescaler currently
+ *          programmed, so it must be called after `hrtim_dt_init`. It can
+ *          then be applied at any time with `hrtim_dt_apply`.
+ *
+ * @param[in] tu_number        Timing unit number:
+ *                  `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
+ * @param[in] rise_ns  The desired dead time of the rising edge in nano second
+ * @param[in] fall_ns  The desired dead time of the falling edge in nano second
+ * @return    Value of the dead time register (DTxR)
+ */
+uint32_t hrtim_dt_compute(hrtim_tu_number_t tu_number,
+                          uint16_t rise_ns,
+                          uint16_t fall_ns);
+
+/**
+ * @brief   Writes a dead time register value previously obtained with
+ *          `hrtim_dt_compute`, in a single register access.
+ *
+ * @param[in] tu_number        Timing unit number:
+ *                  `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
+ * @param[in] dt_reg   Value of the dead time register (DTxR)
+ */
+void hrtim_dt_apply(hrtim_tu_number_t tu_number, uint32_t dt_reg);
+
 /**
  * @brief   Updates the duty cycle of a timing unit
  *
@@ -457,6 +494,9 @@ void hrtim_adc_trigger_dis(hrtim_tu_number_t tu_number);
 /**
  * @brief   Configures the adc rollover mode
  *
+ *          Only used in center-aligned modulation. If the timing unit
+ *          is already running, the new mode is applied immediately.
+ *
  * @param tu_number Timing unit number:
  *                  `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
  *
@@ -479,6 +519,19 @@ hrtim_adc_edgetrigger_t hrtim_adc_rollover_get(hrtim_tu_number_t tu_number);
 
 /**
  * @brief Configures interrupt on repetition counter for the chosen timing unit
+ *
+ * Each timing unit keeps its own callback. The master drives the HRTIM
+ * master interrupt line, while `TIMA`..`TIMF` use their own interrupt
+ * lines, so that several periodic events can run side by side
+ * (e.g. control task on the master and fast sampling on a leg carrier).
+ *
+ * Slave timing units load their preloaded registers (duty cycle, phase,
+ * period) on their repetition event. When a repetition above 1 is set on
+ * a slave timing unit, its update trigger is switched to the counter
+ * roll-over, so that these changes still apply at every period rather
+ * than every `repetition` periods. With a repetition of 1, updates stay
+ * on the repetition event.
+ *
  * @param tu_src timing unit which will be the source for the ISR:
  *                  `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
  * @param repetition value between 1 and 256 for the repetition counter:
@@ -513,6 +566,9 @@ void hrtim_PeriodicEvent_dis(hrtim_tu_t tu);
  * @param repetion value between 1 and 256 for the repetition counter:
  * period of the event write periods of the HRTIM.
  * E.g. when set to 10, one event will be triggered every 10 HRTIM period.
+ *
+ * As for `hrtim_PeriodicEvent_configure()`, a repetition above 1 on a slave
+ * timing unit moves its register updates to the counter roll-over.
  */
 void hrtim_PeriodicEvent_SetRep(hrtim_tu_t tu, uint32_t repetition);
 
@@ -597,6 +653,22 @@ hrtim_external_trigger_t hrtim_eev_get(hrtim_tu_number_t tu_number);
  */
 void hrtim_change_frequency(uint32_t new_frequency);
 
+/**
+ * @brief Change the master period after it has been initialized.
+ *
+ *        Center-aligned timing units get half this period. Duty cycles
+ *        and phase shifts keep their ratio to the period.
+ *
+ * @param[in] new_master_period The new period in master timer ticks,
+ *            see `hrtim_tick_frequency_get()`
+ */
+void hrtim_change_period(uint32_t new_master_period);
+
+/**
+ * @brief Returns the counting frequency of the master timer, in Hz
+ */
+float32_t hrtim_tick_frequency_get();
+
 
 /**
  * @brief Hot swaps the output channels for the timing unit.
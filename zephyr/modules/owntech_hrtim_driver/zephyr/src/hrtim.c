@@ -45,8 +45,12 @@ static float32_t HRTIM_CLK_RESOLUTION = 184e-6;
 /** @brief Defines the HRTIM Clock Minimum Defaulf Frenquency to 200kHz */
 static uint32_t HRTIM_MINIM_FREQUENCY = TU_DEFAULT_FREQ;
 
-/** @brief User callback for ISR */
-static hrtim_callback_t user_callback = NULL;
+/** @brief Index of the master timer in the periodic event tables,
+ *         slave timing units use their hrtim_tu_number_t value */
+#define HRTIM_MSTR_EVENT_INDEX HRTIM_STU_NUMOF
+
+/** @brief User callbacks for ISR, one per timing unit plus the master */
+static hrtim_callback_t user_callback[HRTIM_STU_NUMOF + 1] = {NULL};
 
 /* Default values to initialize all the timer */
 
@@ -396,9 +400,154 @@ void _hrtim_callback()
         LL_GPIO_SetPinMode(GPIOB, LL_GPIO_PIN_1, LL_GPIO_MODE_OUTPUT);
     }
 
-    if (user_callback != NULL)
+    if (user_callback[HRTIM_MSTR_EVENT_INDEX] != NULL)
+    {
+        user_callback[HRTIM_MSTR_EVENT_INDEX]();
+    }
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Handle the repetition event of a slave timing
+ *        unit and call the callback attached to it.
+ *
+ * Each slave timing unit has its own interrupt line, so this handler only
+ * clears the repetition flag of its own unit and never has to look at the
+ * master synchronization configuration.
+ *
+ * @param arg Timing unit number (`PWMA`..`PWMF`) cast to a pointer.
+ */
+static void _hrtim_tu_callback(const void* arg)
+{
+    uint8_t tu_index = (uint8_t)(uintptr_t)arg;
+
+    LL_HRTIM_ClearFlag_REP(HRTIM1, list_tu[tu_index]);
+
+    if (user_callback[tu_index] != NULL)
     {
-        user_callback();
+        user_callback[tu_index]();
+    }
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Returns the index of a timing unit in the
+ *        periodic event tables.
+ *
+ * @param tu Timing unit: `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
+ * @return `PWMA`..`PWMF` for slave timing units,
+ *         `HRTIM_MSTR_EVENT_INDEX` for the master.
+ */
+static uint8_t _hrtim_periodic_event_index(hrtim_tu_t tu)
+{
+    switch (tu)
+    {
+        case TIMA: return PWMA;
+        case TIMB: return PWMB;
+        case TIMC: return PWMC;
+        case TIMD: return PWMD;
+        case TIME: return PWME;
+#if (HRTIM_STU_NUMOF == 6)
+        case TIMF: return PWMF;
+#endif
+        default:   return HRTIM_MSTR_EVENT_INDEX;
+    }
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Sets the repetition counter of a timing unit.
+ *
+ * Slave timing units load their preloaded registers on repetition event:
+ * above one period, they are updated on each counter roll-over instead,
+ * so that duty cycle, phase and period changes still apply at every
+ * carrier period.
+ *
+ * @param tu Timing unit: `MSTR`, `TIMA`, `TIMB`, `TIMC`, `TIMD`, `TIME`, `TIMF`
+ * @param repetition Number of periods between two repetition events
+ */
+static void _hrtim_periodic_event_set_repetition(hrtim_tu_t tu,
+                                                 uint32_t repetition)
+{
+    /* Set repetition counter to repetition-1 so that an event
+     * is triggered every "repetition" number of periods.
+     */
+    LL_HRTIM_TIM_SetRepetition(HRTIM1, tu, repetition - 1);
+
+    if (_hrtim_periodic_event_index(tu) != HRTIM_MSTR_EVENT_INDEX)
+    {
+        LL_HRTIM_TIM_SetUpdateTrig(HRTIM1,
+                                   tu,
+                                   (repetition > 1) ?
+                                   LL_HRTIM_UPDATETRIG_RESET :
+                                   LL_HRTIM_UPDATETRIG_REPETITION);
+    }
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Connects and enables the interrupt line of a
+ *        slave timing unit.
+ *
+ * IRQ_CONNECT needs a constant IRQ number, hence one call per line.
+ *
+ * @param tu_index Timing unit number: `PWMA`..`PWMF`
+ */
+static void _hrtim_tu_irq_enable(uint8_t tu_index)
+{
+    switch (tu_index)
+    {
+        case PWMA:
+            IRQ_CONNECT(HRTIM1_TIMA_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWMA, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIMA_IRQn);
+            break;
+        case PWMB:
+            IRQ_CONNECT(HRTIM1_TIMB_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWMB, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIMB_IRQn);
+            break;
+        case PWMC:
+            IRQ_CONNECT(HRTIM1_TIMC_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWMC, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIMC_IRQn);
+            break;
+        case PWMD:
+            IRQ_CONNECT(HRTIM1_TIMD_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWMD, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIMD_IRQn);
+            break;
+        case PWME:
+            IRQ_CONNECT(HRTIM1_TIME_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWME, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIME_IRQn);
+            break;
+#if (HRTIM_STU_NUMOF == 6)
+        case PWMF:
+            IRQ_CONNECT(HRTIM1_TIMF_IRQn, HRTIM_IRQ_PRIO, _hrtim_tu_callback,
+                        (void*)PWMF, HRTIM_IRQ_FLAGS);
+            irq_enable(HRTIM1_TIMF_IRQn);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief PRIVATE FUNCTION - Disables the interrupt line of a slave timing unit.
+ *
+ * @param tu_index Timing unit number: `PWMA`..`PWMF`
+ */
+static void _hrtim_tu_irq_disable(uint8_t tu_index)
+{
+    switch (tu_index)
+    {
+        case PWMA: irq_disable(HRTIM1_TIMA_IRQn); break;
+        case PWMB: irq_disable(HRTIM1_TIMB_IRQn); break;
+        case PWMC: irq_disable(HRTIM1_TIMC_IRQn); break;
+        case PWMD: irq_disable(HRTIM1_TIMD_IRQn); break;
+        case PWME: irq_disable(HRTIM1_TIME_IRQn); break;
+#if (HRTIM_STU_NUMOF == 6)
+        case PWMF: irq_disable(HRTIM1_TIMF_IRQn); break;
+#endif
+        default: break;
     }
 }
 
@@ -821,6 +970,14 @@ void hrtim_out_en(hrtim_tu_number_t tu_number)
     LL_HRTIM_EnableOutput(HRTIM1, tu_channel[tu_number]->gpio_conf.OUT_L);
 }
 
+bool hrtim_out_is_enabled(hrtim_tu_number_t tu_number)
+{
+    return (LL_HRTIM_IsEnabledOutput(HRTIM1,
+                                     tu_channel[tu_number]->gpio_conf.OUT_H) ||
+            LL_HRTIM_IsEnabledOutput(HRTIM1,
+                                     tu_channel[tu_number]->gpio_conf.OUT_L));
+}
+
 void hrtim_out_dis_single(hrtim_output_units_t PWM_OUT)
 {
     LL_HRTIM_DisableOutput(HRTIM1, PWM_OUT);
@@ -1044,6 +1201,18 @@ hrtim_external_trigger_t hrtim_eev_get(hrtim_tu_number_t tu_number)
  *  without stopping the PWM.
  */
 void hrtim_dt_set(hrtim_tu_number_t tu_number, uint16_t rise_ns, uint16_t fall_ns)
+{
+    /* updates the rise dead time on the structure */
+    tu_channel[tu_number]->pwm_conf.rise_dead_time = rise_ns;
+    /* updates the fall dead time on the structure */
+    tu_channel[tu_number]->pwm_conf.fall_dead_time = fall_ns;
+
+    hrtim_dt_apply(tu_number, hrtim_dt_compute(tu_number, rise_ns, fall_ns));
+}
+
+uint32_t hrtim_dt_compute(hrtim_tu_number_t tu_number,
+                          uint16_t rise_ns,
+                          uint16_t fall_ns)
 {
     #if defined(CONFIG_SOC_SERIES_STM32F3X)
         uint32_t f_hrtim = hrtim_get_apb2_clock() * 2;
@@ -1052,17 +1221,14 @@ void hrtim_dt_set(hrtim_tu_number_t tu_number, uint16_t rise_ns, uint16_t fall_n
     #else
     #warning "unsupported stm32XX family"
     #endif
-    /* updates the rise dead time on the structure */
-    tu_channel[tu_number]->pwm_conf.rise_dead_time = rise_ns;
-    /* updates the fall dead time on the structure */
-    tu_channel[tu_number]->pwm_conf.fall_dead_time = fall_ns;
 
     uint16_t rise_dt = 0;
     uint16_t fall_dt = 0;
     uint32_t rise_ps = rise_ns * 1000;
     uint32_t fall_ps = fall_ns * 1000;
+    uint32_t dt_reg = HRTIM1->sTimerxRegs[tu_number].DTxR;
     /* Dead time prescaler */
-    uint8_t dtpsc = (HRTIM1->sTimerxRegs[tu_number].DTxR>>10U)&(0x7);
+    uint8_t dtpsc = (dt_reg>>10U)&(0x7);
     /* Dead time resolution (see table 222 of RM0440) */
     uint32_t t_dtg_ps = (1 << dtpsc) * 1000000 / ((f_hrtim * 8) / 1000000);
     /* calculate the register value based on desired deadtime in picoseconds */
@@ -1079,15 +1245,18 @@ void hrtim_dt_set(hrtim_tu_number_t tu_number, uint16_t rise_ns, uint16_t fall_n
     {
         fall_dt = 511;
     }
-    /* Deadtime falling edge value */
-    LL_HRTIM_DT_SetFallingValue(HRTIM1,
-                                tu_channel[tu_number]->pwm_conf.pwm_tu,
-                                fall_dt);
 
-    /* Deadtime rising edge value */
-    LL_HRTIM_DT_SetRisingValue(HRTIM1,
-                               tu_channel[tu_number]->pwm_conf.pwm_tu,
-                               rise_dt);
+    /* Keep prescaler, sign and lock bits, replace rising and falling values */
+    dt_reg &= ~(HRTIM_DTR_DTR_Msk | HRTIM_DTR_DTF_Msk);
+    dt_reg |= ((uint32_t)rise_dt << HRTIM_DTR_DTR_Pos);
+    dt_reg |= ((uint32_t)fall_dt << HRTIM_DTR_DTF_Pos);
+
+    return dt_reg;
+}
+
+inline void hrtim_dt_apply(hrtim_tu_number_t tu_number, uint32_t dt_reg)
+{
+    HRTIM1->sTimerxRegs[tu_number].DTxR = dt_reg;
 }
 
 inline void hrtim_duty_cycle_set(hrtim_tu_number_t tu_number, uint16_t value)
@@ -1414,6 +1583,16 @@ void hrtim_adc_rollover_set(hrtim_tu_number_t tu_number,
                             hrtim_adc_edgetrigger_t adc_rollover)
 {
     tu_channel[tu_number]->adc_hrtim.adc_rollover = adc_rollover;
+
+    /* Timing unit already running: apply the new roll-over mode now */
+    if ((tu_channel[tu_number]->pwm_conf.modulation == UpDwn) &&
+        LL_HRTIM_TIM_IsCounterEnabled(HRTIM1,
+                                      tu_channel[tu_number]->pwm_conf.pwm_tu))
+    {
+        LL_HRTIM_TIM_SetADCRollOverMode(HRTIM1,
+                                tu_channel[tu_number]->pwm_conf.pwm_tu,
+                                adc_rollover);
+    }
 }
 
 hrtim_adc_edgetrigger_t hrtim_adc_rollover_get(hrtim_tu_number_t tu_number)
@@ -1424,17 +1603,25 @@ hrtim_adc_edgetrigger_t hrtim_adc_rollover_get(hrtim_tu_number_t tu_number)
 void hrtim_PeriodicEvent_configure(hrtim_tu_t tu, uint32_t repetition,
                                    hrtim_callback_t callback)
 {
-    /* Memorize user callback */
-    user_callback = callback;
+    /* Memorize user callback for this timing unit */
+    user_callback[_hrtim_periodic_event_index(tu)] = callback;
 
-    /* Set repetition counter to repetition-1 so that an event
-     * is triggered every "repetition" number of periods.
-     */
-    LL_HRTIM_TIM_SetRepetition(HRTIM1, tu, repetition - 1);
+    _hrtim_periodic_event_set_repetition(tu, repetition);
 }
 
 void hrtim_PeriodicEvent_en(hrtim_tu_t tu)
 {
+    uint8_t event_index = _hrtim_periodic_event_index(tu);
+
+    if (event_index != HRTIM_MSTR_EVENT_INDEX)
+    {
+        /* Slave timing units have their own interrupt line */
+        LL_HRTIM_ClearFlag_REP(HRTIM1, tu);
+        LL_HRTIM_EnableIT_REP(HRTIM1, tu);
+        _hrtim_tu_irq_enable(event_index);
+        return;
+    }
+
     if (LL_HRTIM_GetSyncInSrc(HRTIM1) == LL_HRTIM_SYNCIN_SRC_NONE)
     {
         /* Enabling the interrupt on repetition counter event*/
@@ -1459,17 +1646,24 @@ void hrtim_PeriodicEvent_en(hrtim_tu_t tu)
 
 void hrtim_PeriodicEvent_dis(hrtim_tu_t tu)
 {
-    irq_disable(HRTIM_IRQ_NUMBER);
+    uint8_t event_index = _hrtim_periodic_event_index(tu);
+
+    if (event_index != HRTIM_MSTR_EVENT_INDEX)
+    {
+        _hrtim_tu_irq_disable(event_index);
+    }
+    else
+    {
+        irq_disable(HRTIM_IRQ_NUMBER);
+    }
+
     /* Disabling the interrupt on repetition counter event */
     LL_HRTIM_DisableIT_REP(HRTIM1, tu);
 }
 
 void hrtim_PeriodicEvent_SetRep(hrtim_tu_t tu, uint32_t repetition)
 {
-    /* Set repetition counter to repetition-1 so that an event
-     * is triggered every "repetition" number of periods.
-     */
-    LL_HRTIM_TIM_SetRepetition(HRTIM1, tu, repetition - 1);
+    _hrtim_periodic_event_set_repetition(tu, repetition);
 }
 
 uint32_t hrtim_PeriodicEvent_GetRep(hrtim_tu_t tu)
@@ -1505,69 +1699,89 @@ void hrtim_change_frequency(uint32_t new_frequency)
         #warning "unsupported stm32XX family"
         #endif
         
-
-        float32_t duty_cycle_ratio;
-        float32_t phase_shift_ratio;
-
-        int16_t  new_shift;
-        uint16_t new_duty;
-        uint16_t new_tu_period;
         uint32_t new_master_period;
 
-        int16_t  old_shift;
-        uint16_t old_duty;
-        uint16_t old_period;
-
-        hrtim_tu_t timing_unit;
-
         new_master_period =
             ((f_hrtim / new_frequency) * 32 +
-            (f_hrtim % new_frequency) * (32 / new_frequency)) /
+            (f_hrtim % new_frequency) * 32 / new_frequency) /
             (1 << timerMaster.pwm_conf.ckpsc);
 
-            timerMaster.pwm_conf.frequency = new_frequency;
-
-    
-            LL_HRTIM_TIM_SetPeriod(HRTIM1, MSTR, new_master_period);
-            
-            timerMaster.pwm_conf.period = new_master_period;
-
-            for(uint8_t channel = PWMA; channel<=PWMF; channel++){
-                timing_unit = tu_channel[channel]->pwm_conf.pwm_tu;                
-                old_duty = tu_channel[channel]->pwm_conf.duty_cycle;
-                old_period = tu_channel[channel]->pwm_conf.period;
-                old_shift = tu_channel[channel]->phase_shift.value;
-                
-                if(tu_channel[channel]->pwm_conf.modulation==UpDwn){
-                    new_tu_period = new_master_period/2;
-                }else{
-                    new_tu_period = new_master_period;
-                }
-
-                duty_cycle_ratio = (float32_t)old_duty/(float32_t)old_period;               
-
-                new_duty = duty_cycle_ratio*new_tu_period;
-
-                LL_HRTIM_TIM_SetPeriod(HRTIM1,timing_unit,new_tu_period);
-                LL_HRTIM_TIM_SetCompare1(HRTIM1,timing_unit,new_duty);                 
-
-                phase_shift_ratio = (float32_t)old_shift/(float32_t)old_period;
-                new_shift = phase_shift_ratio*new_tu_period;
-                
-                tu_channel[channel]->pwm_conf.frequency = new_frequency;
-                hrtim_phase_shift_set(channel, new_shift);
-
-                tu_channel[channel]->pwm_conf.duty_cycle = new_duty;
-                tu_channel[channel]->phase_shift.value = new_shift;
-                tu_channel[channel]->pwm_conf.period = new_tu_period;
-            }
-
+        hrtim_change_period(new_master_period);
 
     }else{
         printk("Minimum frequency = %d \n", timerMaster.pwm_conf.min_frequency);
     }
 }
 
+float32_t hrtim_tick_frequency_get()
+{
+    #if defined(CONFIG_SOC_SERIES_STM32F3X)
+        uint32_t f_hrtim = hrtim_get_apb2_clock() * 2;
+    #elif defined(CONFIG_SOC_SERIES_STM32G4X)
+        uint32_t f_hrtim = hrtim_get_apb2_clock();
+    #else
+    #warning "unsupported stm32XX family"
+    #endif
+
+    /* Master counter runs at 32 x f_hrtim / 2^ckpsc */
+    return ((float32_t)f_hrtim * 32.0F) /
+           (float32_t)(1 << timerMaster.pwm_conf.ckpsc);
+}
+
+void hrtim_change_period(uint32_t new_master_period)
+{
+    float32_t duty_cycle_ratio;
+    float32_t phase_shift_ratio;
+
+    int16_t  new_shift;
+    uint16_t new_duty;
+    uint16_t new_tu_period;
+
+    int16_t  old_shift;
+    uint16_t old_duty;
+    uint16_t old_period;
+
+    hrtim_tu_t timing_unit;
+
+    timerMaster.pwm_conf.frequency = (uint32_t)
+        (hrtim_tick_frequency_get() / new_master_period + 0.5F);
+
+    LL_HRTIM_TIM_SetPeriod(HRTIM1, MSTR, new_master_period);
+
+    timerMaster.pwm_conf.period = new_master_period;
+
+    for(uint8_t channel = PWMA; channel<=PWMF; channel++){
+        timing_unit = tu_channel[channel]->pwm_conf.pwm_tu;
+        old_duty = tu_channel[channel]->pwm_conf.duty_cycle;
+        old_period = tu_channel[channel]->pwm_conf.period;
+        old_shift = tu_channel[channel]->phase_shift.value;
+
+        if(tu_channel[channel]->pwm_conf.modulation==UpDwn){
+            new_tu_period = new_master_period/2;
+        }else{
+            new_tu_period = new_master_period;
+        }
+
+        duty_cycle_ratio = (float32_t)old_duty/(float32_t)old_period;
+
+        new_duty = duty_cycle_ratio*new_tu_period;
+
+        LL_HRTIM_TIM_SetPeriod(HRTIM1,timing_unit,new_tu_period);
+        LL_HRTIM_TIM_SetCompare1(HRTIM1,timing_unit,new_duty);
+
+        phase_shift_ratio = (float32_t)old_shift/(float32_t)old_period;
+        new_shift = phase_shift_ratio*new_tu_period;
+
+        tu_channel[channel]->pwm_conf.frequency =
+                                    timerMaster.pwm_conf.frequency;
+        hrtim_phase_shift_set(channel, new_shift);
+
+        tu_channel[channel]->pwm_conf.duty_cycle = new_duty;
+        tu_channel[channel]->phase_shift.value = new_shift;
+        tu_channel[channel]->pwm_conf.period = new_tu_period;
+    }
+}
+
 void hrtim_output_hot_swap(hrtim_tu_number_t tu_number){
     
     hrtim_switch_convention_t convention = tu_channel[tu_number]->switch_conv.convention;
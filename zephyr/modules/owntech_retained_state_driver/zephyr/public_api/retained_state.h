@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/**
+ * @brief Retained state driver.
+ *
+ * Variables registered with this driver are periodically copied to a
+ * retained RAM area, protected by a CRC, which is not cleared by a
+ * software or watchdog reset. After such a reset (warm boot), registering
+ * a variable again restores the value it had before the reset.
+ *
+ * After a power-on, brown-out, if the retained content is corrupted or
+ * was saved by a different firmware image (cold boot), nothing is restored
+ * and variables keep their initial value.
+ */
+
+#ifndef RETAINED_STATE_H_
+#define RETAINED_STATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Identifier of the sensors calibration, used by the Shield API */
+#define RETAINED_STATE_ID_SENSORS (0x01U)
+
+/** @brief First identifier available to the application */
+#define RETAINED_STATE_ID_USER    (0x80U)
+
+/**
+ * @brief Register a variable to be kept across warm boots.
+ *
+ * If the board went through a warm boot and the retained state holds a
+ * value with the same identifier and size, this value is copied to `data`.
+ *
+ * @param id   Identifier of the variable, must be unique and keep
+ *             the same meaning between firmware versions.
+ * @param data Pointer to the variable. It must remain valid as the
+ *             variable is read at each save.
+ * @param size Size of the variable in bytes.
+ *
+ * @note  Any software reset counts as a warm boot, including the one
+ *        requested after a firmware upload. Do not retain variables that
+ *        start the power stage, such as an operating mode: the board must
+ *        wait for an operator action after any reset.
+ *
+ * @return `1` if the value was restored, `0` if the variable is registered
+ *         without a previous value, `-1` if the identifier is already used
+ *         or the variable does not fit in the retained area.
+ */
+int8_t retained_state_register(uint8_t id, void* data, uint16_t size);
+
+/**
+ * @brief Copy all registered variables to the retained area now.
+ *
+ * This is done periodically (see `CONFIG_OWNTECH_RETAINED_STATE_SAVE_PERIOD_MS`),
+ * call this before a deliberate reset to save the latest values.
+ *
+ * @return `0` on success, `-1` if the retained area could not be written.
+ */
+int8_t retained_state_save();
+
+/**
+ * @brief Invalidate the retained state and stop periodic saves.
+ *
+ * The next boot will be a cold boot, whatever the reset cause.
+ * Call this before resetting into a different firmware.
+ */
+void retained_state_clear();
+
+/**
+ * @brief Returns `true` if the board booted after a software or watchdog
+ *        reset with a valid retained state saved by the same firmware.
+ *
+ * Can be used to skip startup steps such as calibration, whose results
+ * are restored from the retained state.
+ */
+bool retained_state_is_warm_boot();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RETAINED_STATE_H_ */
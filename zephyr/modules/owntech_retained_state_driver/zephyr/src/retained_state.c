@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2025-present LAAS-CNRS
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 2.1 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-2.1
+ */
+
+/*
+ * @date   2025
+ */
+
+/* Stdlib */
+#include <string.h>
+
+/* Zephyr */
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/retention/retention.h>
+#include <zephyr/linker/linker-defs.h>
+#include <zephyr/sys/crc.h>
+
+/* Current file header */
+#include "retained_state.h"
+
+
+/**
+ * Retained state layout:
+ * - 2 bytes layout version
+ * - 1 byte number of entries
+ * - 1 byte reserved
+ * - 4 bytes image identifier, CRC32 of the firmware code and constants
+ * - Then a directory with, for each entry:
+ *   - 1 byte identifier
+ *   - 1 byte reserved
+ *   - 2 bytes data size
+ * - Then data of each entry, in directory order.
+ * Magic prefix and CRC32 are handled by the retention subsystem.
+ */
+static const uint16_t RETAINED_STATE_LAYOUT_VERSION   = 0x0002;
+static const uint8_t  RETAINED_STATE_HEADER_SIZE      = 8;
+static const uint8_t  RETAINED_STATE_DIRECTORY_SIZE   = 4;
+
+#define RETAINED_STATE_NODE DT_NODELABEL(retained_state)
+
+/* Partition size, an upper bound of the usable size */
+#define RETAINED_STATE_MAX_SIZE DT_REG_SIZE(RETAINED_STATE_NODE)
+
+/* Restored entries come in addition to registered ones in the directory */
+#define RETAINED_STATE_DIRECTORY_MAX_SIZE (8 + \
+			4 * 2 * CONFIG_OWNTECH_RETAINED_STATE_MAX_ENTRIES)
+
+static const struct device* retained_state_dev =
+								DEVICE_DT_GET(RETAINED_STATE_NODE);
+
+/** @brief Registered variable */
+typedef struct
+{
+	uint8_t  id;
+	uint16_t size;
+	void*    data;
+} retained_entry_t;
+
+static retained_entry_t entries[CONFIG_OWNTECH_RETAINED_STATE_MAX_ENTRIES];
+static uint8_t entries_count = 0;
+
+/* Content found at boot, entries not registered yet are saved as is */
+static uint8_t restored_image[RETAINED_STATE_MAX_SIZE];
+static uint8_t restored_count = 0;
+static uint32_t restored_claimed = 0;
+
+/* Identifier of the running firmware, a new firmware drops the image */
+static uint32_t image_id = 0;
+
+static bool warm_boot = false;
+static bool save_enabled = true;
+
+K_MUTEX_DEFINE(retained_state_mutex);
+
+static void _retained_state_save_work_handler(struct k_work* work);
+K_WORK_DELAYABLE_DEFINE(save_work, _retained_state_save_work_handler);
+
+/* Private API */
+
+/**
+ * Usable size of the retained area.
+ */
+static uint16_t _retained_state_get_size()
+{
+	ssize_t size = retention_size(retained_state_dev);
+
+	if (size < 0)
+	{
+		return 0;
+	}
+
+	return (size > RETAINED_STATE_MAX_SIZE) ? RETAINED_STATE_MAX_SIZE : size;
+}
+
+/**
+ * Find an entry in the restored image.
+ * Returns the entry index, or -1 if there is none with this identifier.
+ * offset and size are set to the location of the entry data.
+ */
+static int8_t _retained_state_find_restored(uint8_t id,
+											uint16_t* offset,
+											uint16_t* size)
+{
+	uint16_t data_offset = RETAINED_STATE_HEADER_SIZE +
+						   RETAINED_STATE_DIRECTORY_SIZE * restored_count;
+
+	for (uint8_t i = 0 ; i < restored_count ; i++)
+	{
+		uint8_t* directory = &restored_image[RETAINED_STATE_HEADER_SIZE +
+											 RETAINED_STATE_DIRECTORY_SIZE * i];
+		uint16_t entry_size;
+		memcpy(&entry_size, &directory[2], 2);
+
+		if (directory[0] == id)
+		{
+			*offset = data_offset;
+			*size   = entry_size;
+			return i;
+		}
+
+		data_offset += entry_size;
+	}
+
+	return -1;
+}
+
+/**
+ * Check the layout of the restored image.
+ * The image is dropped if its directory does not match its size.
+ */
+static bool _retained_state_check_image(uint16_t image_size)
+{
+	uint16_t layout_version;
+	memcpy(&layout_version, &restored_image[0], 2);
+
+	uint8_t count = restored_image[2];
+
+	uint32_t restored_image_id;
+	memcpy(&restored_image_id, &restored_image[4], 4);
+
+	if ( (layout_version != RETAINED_STATE_LAYOUT_VERSION) ||
+		 (restored_image_id != image_id) ||
+		 (count == 0) ||
+		 (count > CONFIG_OWNTECH_RETAINED_STATE_MAX_ENTRIES) )
+	{
+		return false;
+	}
+
+	uint32_t end = RETAINED_STATE_HEADER_SIZE +
+				   RETAINED_STATE_DIRECTORY_SIZE * count;
+
+	for (uint8_t i = 0 ; i < count ; i++)
+	{
+		uint16_t entry_size;
+		memcpy(&entry_size,
+			   &restored_image[RETAINED_STATE_HEADER_SIZE +
+							   RETAINED_STATE_DIRECTORY_SIZE * i + 2],
+			   2);
+		end += entry_size;
+	}
+
+	return (end <= image_size);
+}
+
+/**
+ * Write one entry data and fill its directory entry.
+ * Returns the offset following the data, or 0 if the entry does not fit.
+ */
+static uint16_t _retained_state_write_entry(uint8_t* directory,
+											uint16_t data_offset,
+											uint16_t area_size,
+											uint8_t id,
+											const void* data,
+											uint16_t size)
+{
+	if (data_offset + size > area_size)
+	{
+		return 0;
+	}
+
+	if (retention_write(retained_state_dev, data_offset, data, size) != 0)
+	{
+		return 0;
+	}
+
+	directory[0] = id;
+	directory[1] = 0;
+	memcpy(&directory[2], &size, 2);
+
+	return data_offset + size;
+}
+
+/**
+ * Periodic save, run by the system work queue.
+ */
+static void _retained_state_save_work_handler(struct k_work* work)
+{
+	ARG_UNUSED(work);
+
+	retained_state_save();
+
+	if (save_enabled == true)
+	{
+		k_work_schedule(&save_work,
+						K_MSEC(CONFIG_OWNTECH_RETAINED_STATE_SAVE_PERIOD_MS));
+	}
+}
+
+/**
+ * Read the reset cause and the retained state.
+ * Run once at boot, before the application.
+ */
+static int _retained_state_init()
+{
+	uint32_t reset_cause = 0;
+
+	if (hwinfo_get_reset_cause(&reset_cause) == 0)
+	{
+		/* Flags accumulate until cleared: keep only the last reset cause */
+		hwinfo_clear_reset_cause();
+	}
+
+	if (device_is_ready(retained_state_dev) == false)
+	{
+		return 0;
+	}
+
+	/* Values saved by another firmware, e.g. before a firmware upload,
+	 * must not be restored: identify the image by its code and constants */
+	image_id = crc32_ieee((const uint8_t*)__rom_region_start,
+						  (size_t)(__rom_region_end - __rom_region_start));
+
+	/* Retained RAM is undefined after power-on or brown-out */
+	bool soft_reset =
+		((reset_cause & (RESET_SOFTWARE | RESET_WATCHDOG)) != 0) &&
+		((reset_cause & (RESET_POR | RESET_BROWNOUT)) == 0);
+
+	if ( (soft_reset == true) &&
+		 (retention_is_valid(retained_state_dev) == 1) )
+	{
+		uint16_t image_size = _retained_state_get_size();
+
+		if ( (image_size >= RETAINED_STATE_HEADER_SIZE) &&
+			 (retention_read(retained_state_dev,
+							 0,
+							 restored_image,
+							 image_size) == 0) &&
+			 (_retained_state_check_image(image_size) == true) )
+		{
+			restored_count = restored_image[2];
+			warm_boot = true;
+		}
+	}
+
+	return 0;
+}
+
+/* Public API */
+
+int8_t retained_state_register(uint8_t id, void* data, uint16_t size)
+{
+	if ( (data == NULL) || (size == 0) ||
+		 (device_is_ready(retained_state_dev) == false) )
+	{
+		return -1;
+	}
+
+	k_mutex_lock(&retained_state_mutex, K_FOREVER);
+
+	uint32_t required_size = RETAINED_STATE_HEADER_SIZE +
+		RETAINED_STATE_DIRECTORY_SIZE * (entries_count + 1) + size;
+
+	for (uint8_t i = 0 ; i < entries_count ; i++)
+	{
+		if (entries[i].id == id)
+		{
+			k_mutex_unlock(&retained_state_mutex);
+			return -1;
+		}
+
+		required_size += entries[i].size;
+	}
+
+	if ( (entries_count >= CONFIG_OWNTECH_RETAINED_STATE_MAX_ENTRIES) ||
+		 (required_size > _retained_state_get_size()) )
+	{
+		k_mutex_unlock(&retained_state_mutex);
+		return -1;
+	}
+
+	entries[entries_count].id   = id;
+	entries[entries_count].size = size;
+	entries[entries_count].data = data;
+	entries_count++;
+
+	int8_t restored = 0;
+	uint16_t restored_offset;
+	uint16_t restored_size;
+	int8_t restored_index = _retained_state_find_restored(id,
+														  &restored_offset,
+														  &restored_size);
+
+	if (restored_index >= 0)
+	{
+		/* Entry is now saved from the variable, even if not restored */
+		restored_claimed |= 1U << restored_index;
+
+		if (restored_size == size)
+		{
+			memcpy(data, &restored_image[restored_offset], size);
+			restored = 1;
+		}
+	}
+
+	k_mutex_unlock(&retained_state_mutex);
+
+	if ( (CONFIG_OWNTECH_RETAINED_STATE_SAVE_PERIOD_MS > 0) &&
+		 (save_enabled == true) )
+	{
+		/* Does nothing if the periodic save is already scheduled */
+		k_work_schedule(&save_work,
+						K_MSEC(CONFIG_OWNTECH_RETAINED_STATE_SAVE_PERIOD_MS));
+	}
+
+	return restored;
+}
+
+int8_t retained_state_save()
+{
+	if (device_is_ready(retained_state_dev) == false)
+	{
+		return -1;
+	}
+
+	k_mutex_lock(&retained_state_mutex, K_FOREVER);
+
+	if (save_enabled == false)
+	{
+		k_mutex_unlock(&retained_state_mutex);
+		return -1;
+	}
+
+	uint8_t directory[RETAINED_STATE_DIRECTORY_MAX_SIZE];
+	uint16_t area_size = _retained_state_get_size();
+	uint8_t count = entries_count;
+
+	for (uint8_t i = 0 ; i < restored_count ; i++)
+	{
+		if ( (restored_claimed & (1U << i)) == 0 )
+		{
+			count++;
+		}
+	}
+
+	/* Data is written first, then the directory that describes it */
+	uint16_t data_offset = RETAINED_STATE_HEADER_SIZE +
+						   RETAINED_STATE_DIRECTORY_SIZE * count;
+	uint8_t written = 0;
+	int8_t ret = 0;
+
+	for (uint8_t i = 0 ; (i < entries_count) && (ret == 0) ; i++)
+	{
+		data_offset = _retained_state_write_entry(
+			&directory[RETAINED_STATE_HEADER_SIZE +
+					   RETAINED_STATE_DIRECTORY_SIZE * written],
+			data_offset,
+			area_size,
+			entries[i].id,
+			entries[i].data,
+			entries[i].size);
+
+		ret = (data_offset == 0) ? -1 : 0;
+		written++;
+	}
+
+	/* Keep entries of the previous boot until they are registered again */
+	uint16_t restored_offset = RETAINED_STATE_HEADER_SIZE +
+							   RETAINED_STATE_DIRECTORY_SIZE * restored_count;
+
+	for (uint8_t i = 0 ; (i < restored_count) && (ret == 0) ; i++)
+	{
+		uint8_t* restored_directory =
+			&restored_image[RETAINED_STATE_HEADER_SIZE +
+							RETAINED_STATE_DIRECTORY_SIZE * i];
+		uint16_t restored_size;
+		memcpy(&restored_size, &restored_directory[2], 2);
+
+		if ( (restored_claimed & (1U << i)) == 0 )
+		{
+			data_offset = _retained_state_write_entry(
+				&directory[RETAINED_STATE_HEADER_SIZE +
+						   RETAINED_STATE_DIRECTORY_SIZE * written],
+				data_offset,
+				area_size,
+				restored_directory[0],
+				&restored_image[restored_offset],
+				restored_size);
+
+			ret = (data_offset == 0) ? -1 : 0;
+			written++;
+		}
+
+		restored_offset += restored_size;
+	}
+
+	if (ret == 0)
+	{
+		memcpy(&directory[0], &RETAINED_STATE_LAYOUT_VERSION, 2);
+		directory[2] = count;
+		directory[3] = 0;
+		memcpy(&directory[4], &image_id, 4);
+
+		if (retention_write(retained_state_dev,
+							0,
+							directory,
+							RETAINED_STATE_HEADER_SIZE +
+							RETAINED_STATE_DIRECTORY_SIZE * count) != 0)
+		{
+			ret = -1;
+		}
+	}
+
+	k_mutex_unlock(&retained_state_mutex);
+
+	return ret;
+}
+
+void retained_state_clear()
+{
+	k_mutex_lock(&retained_state_mutex, K_FOREVER);
+
+	save_enabled = false;
+	restored_count = 0;
+
+	if (device_is_ready(retained_state_dev) == true)
+	{
+		retention_clear(retained_state_dev);
+	}
+
+	k_mutex_unlock(&retained_state_mutex);
+
+	k_work_cancel_delayable(&save_work);
+}
+
+bool retained_state_is_warm_boot()
+{
+	return warm_boot;
+}
+
+
+/**
+ *  Zephyr macro to automatically run above function
+ */
+
+/* Reset cause must be read before the application starts */
+SYS_INIT(_retained_state_init,
+		 APPLICATION,
+		 CONFIG_APPLICATION_INIT_PRIORITY
+		);
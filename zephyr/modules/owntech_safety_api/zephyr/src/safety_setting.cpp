@@ -68,6 +68,11 @@
 /* sensors that need to be watched (true) / ignored (false) */
 static bool sensor_watch[DT_SENSORS_NUMBER + 1];
 
+/* Compact list of the watched sensors, walked by safety_watch() so that
+ * the critical task only visits sensors that are actually monitored */
+static uint8_t watched_sensors[DT_SENSORS_NUMBER + 1];
+static uint8_t watched_sensors_count = 0;
+
 /* threshold max for each sensor */
 static float32_t sensor_threshold_max[DT_SENSORS_NUMBER + 1];
 
@@ -105,6 +110,23 @@ static bool safety_enable = true;
  * Private Functions
  */
 
+/**
+ * @brief Rebuilds the list of watched sensors from sensor_watch[]
+ */
+static void _update_watched_sensors(void)
+{
+    watched_sensors_count = 0;
+
+    for (uint8_t i = 1; i <= DT_SENSORS_NUMBER; i++)
+    {
+        if (sensor_watch[i])
+        {
+            watched_sensors[watched_sensors_count] = i;
+            watched_sensors_count++;
+        }
+    }
+}
+
 /**
  * @brief This function enables the short-circuit mode
  *        i.e. the high-side switch is left open and
@@ -167,6 +189,8 @@ int8_t safety_set_sensor_watch(sensor_t * safety_sensors,
         sensor_watch[safety_sensors[i]] = true;
     }
 
+    _update_watched_sensors();
+
     return 0;
 }
 
@@ -197,6 +221,8 @@ int8_t safety_unset_sensor_watch(sensor_t * safety_sensors,
         sensor_watch[safety_sensors[i]] = false;
     }
 
+    _update_watched_sensors();
+
     return 0;
 }
 
@@ -295,23 +321,22 @@ int8_t safety_watch()
 {
     uint8_t status = 0;
 
-    for (uint8_t i = 0; i < DT_SENSORS_NUMBER; i++)
+    for (uint8_t k = 0; k < watched_sensors_count; k++)
     {
-        if (sensor_watch[i])
-        {
-            float32_t measure =
-                    shield.sensors.peekLatestValue(static_cast<sensor_t>(i));
-
-            if (measure != -10000){
-                sensor_errors[i] =
-                    (measure > sensor_threshold_max[i] ||
-                     measure < sensor_threshold_min[i])
-                     ? true
-                     : false;
-            }
-            if (sensor_errors[i])
-                status = -1;
+        uint8_t i = watched_sensors[k];
+
+        float32_t measure =
+                shield.sensors.peekLatestValue(static_cast<sensor_t>(i));
+
+        if (measure != -10000){
+            sensor_errors[i] =
+                (measure > sensor_threshold_max[i] ||
+                 measure < sensor_threshold_min[i])
+                 ? true
+                 : false;
         }
+        if (sensor_errors[i])
+            status = -1;
     }
 
     return status;
@@ -382,7 +407,7 @@ int8_t safety_task()
 int8_t safety_store_threshold_in_nvs(sensor_t sensor)
 {
 
-	uint8_t* buffer = (uint8_t*)k_malloc(1 + 23 + 4 + 4);
+	uint8_t buffer[1 + 23 + 4 + 4] = {0};
 
 	uint8_t string_len = strlen((char*)(&buffer[1]));
 
@@ -397,8 +422,6 @@ int8_t safety_store_threshold_in_nvs(sensor_t sensor)
                                     buffer,
                                     1 + string_len + 1 + 4 + 4);
 
-	k_free(buffer);
-
 	if (ns < 0)
 	{
 		return -1;
@@ -428,8 +451,8 @@ int8_t  safety_retrieve_threshold_in_nvs(sensor_t sensor)
 
 	uint16_t sensor_ID = MEASURE_THRESHOLD | (sensor&0x0F);
 
-	int buffer_size = 1 + 23 + 4 + 4;
-	uint8_t* buffer = (uint8_t*)k_malloc(buffer_size);
+	uint8_t buffer[1 + 23 + 4 + 4];
+	int buffer_size = sizeof(buffer);
 
 	int read_size = nvs_storage_retrieve_data(sensor_ID, buffer, buffer_size);
 
@@ -457,6 +480,5 @@ int8_t  safety_retrieve_threshold_in_nvs(sensor_t sensor)
 		ret = -4;
 	}
 
-	k_free(buffer);
 	return ret;
 }
@@ -28,6 +28,10 @@
 #include "power_init.h"
 #include "Power.h"
 #include "SpinAPI.h"
+#include "ShieldAPI.h"
+
+/* Largest master period that keeps the HRTIM compare margins */
+static const uint32_t HRTIM_MASTER_PERIOD_MAX = 0xFFDF;
 
 
 hrtim_tu_number_t PowerAPI::spinNumberToTu(uint16_t spin_number)
@@ -62,6 +66,18 @@ hrtim_tu_number_t PowerAPI::spinNumberToTu(uint16_t spin_number)
     }
 }
 
+PowerAPI::PowerAPI()
+{
+    for (uint8_t i = 0; i < ALL; i++)
+    {
+        leg_hot[i].tu = (i < dt_leg_count) ? spinNumberToTu(dt_pwm_pin[i])
+                                           : LEG_TU_NONE;
+        leg_hot[i].swap_count = 0;
+        leg_hot[i].dt_level = DEAD_TIME_LEVEL_NONE;
+        dead_time_levels[i] = 0;
+    }
+}
+
 void PowerAPI::initMode(leg_t leg,
                         hrtim_switch_convention_t leg_convention,
                         hrtim_pwm_mode_t leg_mode)
@@ -137,6 +153,11 @@ void PowerAPI::initMode(leg_t leg,
         /* Initialize leg unit */
         spin.pwm.initUnit(spinNumberToTu(dt_pwm_pin[i]));
 
+        /* Reset the hot descriptor used by the duty cycle update path */
+        leg_hot[i].swap_count = 0;
+        leg_hot[i].dt_level = DEAD_TIME_LEVEL_NONE;
+        dead_time_levels[i] = 0;
+
         /* Configure PWM initial phase shift */
         spin.pwm.setPhaseShift(spinNumberToTu(dt_pwm_pin[i]),
                                dt_phase_shift[i]);
@@ -208,7 +229,15 @@ void PowerAPI::setDutyCycle(leg_t leg, float32_t duty_value)
     uint16_t period;
     uint16_t value;
 
-    period = tu_channel[spinNumberToTu(dt_pwm_pin[leg])]->pwm_conf.period;
+    /* All legs share the same carrier period, use the first one for ALL */
+    hrtim_tu_number_t leg_tu = leg_hot[(leg == ALL) ? 0 : leg].tu;
+
+    if (leg_tu == LEG_TU_NONE)
+    {
+        return;
+    }
+
+    period = tu_channel[leg_tu]->pwm_conf.period;
     value = duty_value * period;
 
     setDutyCycleRaw(leg, value);
@@ -217,7 +246,6 @@ void PowerAPI::setDutyCycle(leg_t leg, float32_t duty_value)
 void PowerAPI::setDutyCycleRaw(leg_t leg, uint16_t duty_value)
 {
     uint16_t period;
-    uint8_t swap_state;
     hrtim_tu_number_t leg_tu;
     uint16_t duty_cycle_max_raw;
     uint16_t duty_cycle_min_raw;
@@ -240,7 +268,12 @@ void PowerAPI::setDutyCycleRaw(leg_t leg, uint16_t duty_value)
 
     for (int8_t i = startIndex; i < endIndex; i++)
     {
-        leg_tu = spinNumberToTu(dt_pwm_pin[i]);
+        leg_tu = leg_hot[i].tu;
+
+        if (leg_tu == LEG_TU_NONE)
+        {
+            continue;
+        }
 
         duty_cycle_max_raw = tu_channel[leg_tu]->pwm_conf.duty_max_user;
         duty_cycle_min_raw = tu_channel[leg_tu]->pwm_conf.duty_min_user;
@@ -256,24 +289,33 @@ void PowerAPI::setDutyCycleRaw(leg_t leg, uint16_t duty_value)
         }
         
         period = tu_channel[leg_tu]->pwm_conf.period;
-        swap_state = tu_channel[leg_tu]->pwm_conf.duty_swap;
 
-        /* Implements a logic that allows for a duty cycle of 100% */
-        if (duty_value >= period-3){
-            duty_value = 0;
-            hrtim_duty_cycle_set(leg_tu, duty_value);
-        
-            if(swap_state == false){ 
+        /**
+         * Implements a logic that allows for a duty cycle of 100%.
+         * Outputs are swapped and the compare is held at zero, so the HRTIM
+         * is only written when entering or leaving this state.
+         * The swap state is the one of the HRTIM driver, shared with
+         * `spin.pwm.setDutyCycleRaw()`.
+         */
+        bool swapped = tu_channel[leg_tu]->pwm_conf.duty_swap;
+
+        if (duty_value >= period-3)
+        {
+            if (swapped == false)
+            {
+                hrtim_duty_cycle_set(leg_tu, 0);
                 hrtim_output_hot_swap(leg_tu);
-            }        
+                leg_hot[i].swap_count++;
+            }
         }
         else
-        {    
-            if(swap_state == true) {
-                hrtim_duty_cycle_set(leg_tu, duty_value);
+        {
+            hrtim_duty_cycle_set(leg_tu, duty_value);
+
+            if (swapped == true)
+            {
                 hrtim_output_hot_swap(leg_tu);
-            }else{
-                hrtim_duty_cycle_set(leg_tu, duty_value);
+                leg_hot[i].swap_count++;
             }
         }
     }
@@ -357,6 +399,27 @@ void PowerAPI::stop(leg_t leg)
     }
 }
 
+bool PowerAPI::isStarted(leg_t leg)
+{
+    int8_t startIndex = (leg == ALL) ? 0 : leg;
+    int8_t endIndex = (leg == ALL) ? dt_leg_count : leg + 1;
+
+    if (startIndex >= dt_leg_count)
+    {
+        return false;
+    }
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        if (hrtim_out_is_enabled(spinNumberToTu(dt_pwm_pin[i])))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 #ifdef CONFIG_SHIELD_TWIST
 
 void PowerAPI::connectCapacitor(leg_t leg)
@@ -603,6 +666,100 @@ void PowerAPI::setDeadTime(leg_t leg,
     {
         spin.pwm.setDeadTime(spinNumberToTu(dt_pwm_pin[i]),
                              ns_rising_dt, ns_falling_dt);
+
+        /* Dead time no longer matches any table entry */
+        leg_hot[i].dt_level = DEAD_TIME_LEVEL_NONE;
+    }
+}
+
+int8_t PowerAPI::setDeadTimeTable(leg_t leg,
+                                  const uint16_t* rise_ns,
+                                  const uint16_t* fall_ns,
+                                  uint8_t level_count)
+{
+    int8_t startIndex = 0;
+    int8_t endIndex = 0;
+
+    if (level_count == 0 || level_count > DEAD_TIME_LEVELS_MAX)
+    {
+        return -1;
+    }
+
+    /*  If ALL is selected, loop through all legs */
+    if(leg == ALL)
+    {
+        startIndex = 0;
+        /* retrieves the total number of legs */
+        endIndex = dt_leg_count;
+    }
+    else
+    {
+        /* Treat `leg` as the specific leg index */
+        startIndex = leg;
+        /* Only iterate for this specific leg */
+        endIndex = leg + 1;
+    }
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        if (leg_hot[i].tu == LEG_TU_NONE)
+        {
+            return -1;
+        }
+    }
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        for (uint8_t level = 0; level < level_count; level++)
+        {
+            dead_time_table[i][level] = hrtim_dt_compute(leg_hot[i].tu,
+                                                         rise_ns[level],
+                                                         fall_ns[level]);
+            dead_time_rise_ns[i][level] = rise_ns[level];
+            dead_time_fall_ns[i][level] = fall_ns[level];
+        }
+        dead_time_levels[i] = level_count;
+        leg_hot[i].dt_level = DEAD_TIME_LEVEL_NONE;
+    }
+
+    return 0;
+}
+
+void PowerAPI::applyDeadTimeLevel(leg_t leg, uint8_t level)
+{
+    int8_t startIndex = 0;
+    int8_t endIndex = 0;
+
+    /*  If ALL is selected, loop through all legs */
+    if(leg == ALL)
+    {
+        startIndex = 0;
+        /* retrieves the total number of legs */
+        endIndex = dt_leg_count;
+    }
+    else
+    {
+        /* Treat `leg` as the specific leg index */
+        startIndex = leg;
+        /* Only iterate for this specific leg */
+        endIndex = leg + 1;
+    }
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        /* A leg without timing unit never gets a table, its level count
+         * stays at zero */
+        if (level < dead_time_levels[i] && level != leg_hot[i].dt_level)
+        {
+            hrtim_dt_apply(leg_hot[i].tu, dead_time_table[i][level]);
+            leg_hot[i].dt_level = level;
+
+            /* Keep the driver configuration in line with the hardware */
+            tu_channel[leg_hot[i].tu]->pwm_conf.rise_dead_time =
+                                                dead_time_rise_ns[i][level];
+            tu_channel[leg_hot[i].tu]->pwm_conf.fall_dead_time =
+                                                dead_time_fall_ns[i][level];
+        }
     }
 }
 
@@ -763,6 +920,204 @@ uint16_t PowerAPI::getPeriod(leg_t leg){
     return  tu_channel[leg_tu]->pwm_conf.period; 
 }
 
+uint32_t PowerAPI::getSwapCount(leg_t leg){
+    if (leg >= ALL || leg_hot[leg].tu == LEG_TU_NONE)
+    {
+        return 0;
+    }
+
+    return leg_hot[leg].swap_count;
+}
+
+uint16_t PowerAPI::setSynchronousPwm(float32_t fundamental_frequency)
+{
+    uint32_t ratio;
+    uint32_t master_period;
+
+    if (fundamental_frequency <= 0)
+    {
+        return 0;
+    }
+
+    /* Closest multiple of 3 to the default carrier frequency */
+    ratio = 3 * (uint32_t)(timer_frequency / (3 * fundamental_frequency)
+                           + 0.5F);
+
+    /* Stay at or above the minimum carrier frequency */
+    while ((ratio == 0) || (ratio * fundamental_frequency < timer_min_frequency))
+    {
+        ratio += 3;
+    }
+
+    if (ratio > UINT16_MAX)
+    {
+        return 0;
+    }
+
+    /**
+     * The carrier period is set in timer ticks so that `ratio` carrier
+     * periods make one fundamental period, rather than going through an
+     * integer frequency. It is kept even so that center-aligned legs,
+     * which count half the master period, stay exactly synchronous.
+     */
+    float32_t tick_frequency = hrtim_tick_frequency_get();
+
+    master_period = (uint32_t)(tick_frequency /
+                               (ratio * fundamental_frequency) + 0.5F);
+    master_period = (master_period + 1) & ~1U;
+
+    if (master_period < 2 || master_period > HRTIM_MASTER_PERIOD_MAX)
+    {
+        return 0;
+    }
+
+    hrtim_change_period(master_period);
+
+    synchronous_ratio = ratio;
+    synchronous_fundamental = tick_frequency / (master_period * ratio);
+
+    return synchronous_ratio;
+}
+
+uint16_t PowerAPI::getSynchronousRatio()
+{
+    return synchronous_ratio;
+}
+
+float32_t PowerAPI::getSynchronousFundamental()
+{
+    return synchronous_fundamental;
+}
+
+float32_t PowerAPI::getCarrierPeriodScale()
+{
+    return (hrtim_period_Master_get() * timer_frequency) /
+           hrtim_tick_frequency_get();
+}
+
+int8_t PowerAPI::initPeakCurrentMode(leg_t leg,
+                                     sensor_t current_sensor,
+                                     float32_t slope_current)
+{
+    uint8_t dac_number;
+
+    if (leg >= dt_leg_count)
+    {
+        return -1;
+    }
+
+    /* Only legs with a comparator on their current sense pin */
+    if (dt_current_pin[leg] == CM_DAC1)
+    {
+        dac_number = 1;
+    }
+    else if (dt_current_pin[leg] == CM_DAC3)
+    {
+        dac_number = 3;
+    }
+    else
+    {
+        return -1;
+    }
+
+    if (shield.sensors.retrieveStoredConversionType(current_sensor) !=
+        conversion_linear)
+    {
+        return -1;
+    }
+
+    leg_peak_current[leg].sensor = current_sensor;
+    leg_peak_current[leg].slope_current = slope_current;
+
+    if (updatePeakCurrentScale(leg) != 0)
+    {
+        return -1;
+    }
+
+    initBuck(leg, CURRENT_MODE);
+
+    leg_peak_current[leg].dac_number = dac_number;
+
+    /* Start from the lowest reference: the switch turns off at once */
+    setPeakCurrent(leg, leg_peak_current[leg].sensor_offset);
+
+    return 0;
+}
+
+int8_t PowerAPI::updatePeakCurrentScale(leg_t leg)
+{
+    leg_peak_current_t* peak = &leg_peak_current[leg];
+
+    /* Read the version first: a change during the update is seen next time */
+    peak->parameters_version = data_conversion_get_parameters_version();
+
+    float32_t sensor_gain =
+        shield.sensors.retrieveStoredParameterValue(peak->sensor, gain);
+
+    /**
+     * Sensor gives current = gain * raw + offset, with raw the ADC code.
+     * ADC and DAC share the same reference, so the comparator threshold
+     * in DAC code for a given current is (current - offset) / gain.
+     */
+    peak->sensor_offset =
+        shield.sensors.retrieveStoredParameterValue(peak->sensor, offset);
+
+    /* Comparator voltage must rise with current */
+    if (sensor_gain <= 0)
+    {
+        peak->volt_per_ampere = 0;
+        return -1;
+    }
+
+    peak->volt_per_ampere = DAC_VREF / (DAC_RESOLUTION * sensor_gain);
+
+    return 0;
+}
+
+void PowerAPI::setPeakCurrent(leg_t leg, float32_t peak_current)
+{
+    int8_t startIndex = (leg == ALL) ? 0 : leg;
+    int8_t endIndex = (leg == ALL) ? dt_leg_count : leg + 1;
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        leg_peak_current_t* peak = &leg_peak_current[i];
+
+        if (peak->dac_number == 0)
+        {
+            continue;
+        }
+
+        /* A calibration done after initPeakCurrentMode() is taken
+         * into account */
+        if (peak->parameters_version !=
+            data_conversion_get_parameters_version())
+        {
+            updatePeakCurrentScale(static_cast<leg_t>(i));
+        }
+
+        float32_t volt_per_ampere = peak->volt_per_ampere;
+
+        if (volt_per_ampere <= 0)
+        {
+            continue;
+        }
+
+        float32_t set_voltage = (peak_current - peak->sensor_offset) *
+                                volt_per_ampere;
+
+        if (set_voltage < 0)
+        {
+            set_voltage = 0;
+        }
+
+        spin.dac.slopeCompensation(peak->dac_number,
+                                   set_voltage,
+                                   set_voltage -
+                                   peak->slope_current * volt_per_ampere);
+    }
+}
+
 
 void PowerAPI::setAdcDecim(leg_t leg, uint16_t adc_decim)
 {
@@ -791,6 +1146,65 @@ void PowerAPI::setAdcDecim(leg_t leg, uint16_t adc_decim)
 }
 
 
+int8_t PowerAPI::setAdcSamplesPerPeriod(leg_t leg, uint8_t samples_count)
+{
+    int8_t startIndex = (leg == ALL) ? 0 : leg;
+    int8_t endIndex = (leg == ALL) ? dt_leg_count : leg + 1;
+
+    if (samples_count < 1 || samples_count > 2 || spin.data.started())
+    {
+        return -1;
+    }
+
+    /* Each edge converts the whole sequence, which must be over before
+     * the opposite edge triggers the ADC again */
+    uint32_t half_period_ns = (uint32_t)((hrtim_period_Master_get() *
+                                          500000000.0F) /
+                                         hrtim_tick_frequency_get());
+
+    /* Check all legs before configuring any of them */
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        hrtim_tu_number_t tu = spinNumberToTu(dt_pwm_pin[i]);
+
+        if (dt_adc[i] == UNKNOWN_ADC || samples_count == 1)
+        {
+            continue;
+        }
+
+        if (tu_channel[tu]->pwm_conf.modulation != UpDwn ||
+            spin.data.getSequenceTimeNs(dt_adc[i]) > half_period_ns)
+        {
+            return -1;
+        }
+    }
+
+    for (int8_t i = startIndex; i < endIndex; i++)
+    {
+        hrtim_tu_number_t tu = spinNumberToTu(dt_pwm_pin[i]);
+
+        if (dt_adc[i] == UNKNOWN_ADC)
+        {
+            continue;
+        }
+
+        /* Two samples: trigger on both counting directions of the carrier */
+        spin.pwm.setAdcEdgeTrigger(tu, (samples_count == 2) ?
+                                       EdgeTrigger_Both : dt_edge_trigger[i]);
+
+        /* Averaging needs the whole sequence converted on each edge,
+         * discontinuous mode would convert one channel per edge */
+        if (samples_count == 2)
+        {
+            spin.data.configureDiscontinuousMode(dt_adc[i], 0);
+        }
+
+        spin.data.configureAveraging(dt_adc[i], samples_count);
+    }
+
+    return 0;
+}
+
 void PowerAPI::initBuck(leg_t leg, hrtim_pwm_mode_t leg_mode)
 {
     int8_t startIndex = 0;
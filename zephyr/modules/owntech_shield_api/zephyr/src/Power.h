@@ -33,9 +33,19 @@
 #include <zephyr/kernel.h>
 #include "arm_math.h"
 #include "hrtim_enum.h"
+#include "Sensors.h"
 
 #define LEG_TOKEN(node_id) DT_STRING_TOKEN(node_id, leg_name),
 
+/* Maximum number of entries in the dead time table of a leg */
+#define DEAD_TIME_LEVELS_MAX (8U)
+
+/* Dead time level value meaning no table entry is currently applied */
+#define DEAD_TIME_LEVEL_NONE (0xFFU)
+
+/* Timing unit value of a leg that is not described in the device tree */
+#define LEG_TU_NONE ((hrtim_tu_number_t)(PWMF + 1))
+
 /**  @brief Parses all the legs with okay status in the device tree and fills 
  * 			this type def. 
  * 
@@ -50,14 +60,82 @@ typedef enum
 	ALL
 } leg_t;
 
+/**
+ * @brief Per-leg state read on the duty cycle update path.
+ *
+ *        - `tu` - timing unit driving the leg, resolved once at construction,
+ *                 `LEG_TU_NONE` for legs absent from the device tree
+ *
+ *        - `swap_count` - number of swap state transitions since init
+ *
+ *        - `dt_level` - dead time table entry currently applied
+ */
+typedef struct
+{
+	hrtim_tu_number_t tu;
+	uint32_t swap_count;
+	uint8_t dt_level;
+} leg_hot_t;
+
+/**
+ * @brief Per-leg state of peak current mode, see
+ *        `PowerAPI::initPeakCurrentMode()`.
+ *
+ *        - `dac_number` - DAC feeding the leg comparator, `0` when the leg
+ *          is not in peak current mode
+ *
+ *        - `sensor` - sensor measuring the leg current, whose conversion
+ *          parameters convert references to comparator voltages
+ *
+ *        - `slope_current` - slope compensation ramp amplitude, in A
+ *
+ *        - `volt_per_ampere`, `sensor_offset` - comparator voltage scale
+ *          and sensor offset, derived from the sensor conversion parameters
+ *
+ *        - `parameters_version` - version of the conversion parameters
+ *          the scale was derived from
+ */
+typedef struct
+{
+	uint8_t dac_number;
+	sensor_t sensor;
+	float32_t slope_current;
+	float32_t volt_per_ampere;
+	float32_t sensor_offset;
+	uint32_t parameters_version;
+} leg_peak_current_t;
+
 class PowerAPI
 {
 private:
 	/* return timing unit from spin pin number */
 	hrtim_tu_number_t spinNumberToTu(uint16_t spin_number);
 
+	/* hot descriptor of each leg, filled at construction */
+	leg_hot_t leg_hot[ALL];
+
+	/* precomputed dead time register values of each leg */
+	uint32_t dead_time_table[ALL][DEAD_TIME_LEVELS_MAX];
+	uint16_t dead_time_rise_ns[ALL][DEAD_TIME_LEVELS_MAX];
+	uint16_t dead_time_fall_ns[ALL][DEAD_TIME_LEVELS_MAX];
+	uint8_t dead_time_levels[ALL];
+
+	/* carrier to fundamental ratio in synchronous PWM, 0 if asynchronous */
+	uint16_t synchronous_ratio;
+	float32_t synchronous_fundamental;
+
+	/* peak current mode state of each leg */
+	leg_peak_current_t leg_peak_current[ALL];
+
+	/* derive the comparator scale of a leg from its sensor parameters */
+	int8_t updatePeakCurrentScale(leg_t leg);
 
 public:
+	/**
+	 * @brief Resolve the timing unit of each leg from the device tree.
+	 */
+	PowerAPI();
+
 	/**
 	 * @brief Initialize the power mode for a given leg.
 	 *
@@ -126,6 +204,16 @@ public:
 	 */
 	void stop(leg_t leg);
 
+	/**
+	 * @brief Check if the power output of a leg is started.
+	 *
+	 * @param leg The leg to check: `LEG1` to `ALL`
+	 *
+	 * @return `true` if an output of the leg, or of any leg for `ALL`,
+	 * 		   is started.
+	 */
+	bool isStarted(leg_t leg);
+
 	/**
 	 * @brief Connect the electrolytic capacitor.
 	 *
@@ -216,6 +304,41 @@ public:
 					 uint16_t ns_rising_dt,
 					 uint16_t ns_falling_dt);
 
+	/**
+	 * @brief Precompute a table of dead time values for a leg
+	 *
+	 * Each entry is converted once to its register value so that it can
+	 * later be applied with `applyDeadTimeLevel`, e.g. to adapt dead time
+	 * to the current magnitude or temperature while the leg is running.
+	 *
+	 * @param leg the leg for which to build the table: `LEG1` to `ALL`
+	 * @param rise_ns array of `level_count` rising dead times in nanoseconds
+	 * @param fall_ns array of `level_count` falling dead times in nanoseconds
+	 * @param level_count number of levels, between 1 and
+	 * 					  `DEAD_TIME_LEVELS_MAX`
+	 *
+	 * @return `0` if the table was built, `-1` if `level_count` is invalid
+	 * 		   or the leg is not described in the device tree.
+	 *
+	 * @warning This function can only be called AFTER initializing the LEG,
+	 * 			as register values depend on the dead time prescaler.
+	 */
+	int8_t setDeadTimeTable(leg_t leg,
+							const uint16_t* rise_ns,
+							const uint16_t* fall_ns,
+							uint8_t level_count);
+
+	/**
+	 * @brief Apply a dead time level from the precomputed table of a leg
+	 *
+	 * Costs a single register write per leg, and nothing if the level is
+	 * already applied. Can be called from the critical task.
+	 *
+	 * @param leg the leg for which to apply the level: `LEG1` to `ALL`
+	 * @param level index of the table entry to apply
+	 */
+	void applyDeadTimeLevel(leg_t leg, uint8_t level);
+
 	/**
 	 * @brief sets the Minimum Duty Cycle Limit
 	 *
@@ -288,6 +411,66 @@ public:
 	*/
 	uint16_t getPeriod(leg_t leg);
 
+	/**
+	 * @brief returns the number of output swap transitions of a leg
+	 *
+	 * Outputs are hot-swapped each time the duty cycle enters or leaves
+	 * the 100% region. This counter is meant for diagnostics.
+	 *
+	 * @param leg the leg for which to get the swap count: `LEG1` to `LEG5`.
+	 * @return the swap count, `0` for `ALL` or a leg that is not described
+	 * 		   in the device tree.
+	 * @warning `ALL` is NOT supported !
+	*/
+	uint32_t getSwapCount(leg_t leg);
+
+	/**
+	 * @brief Switch to synchronous PWM for a fundamental frequency
+	 *
+	 * The carrier frequency of all legs is retuned to the multiple of 3 of
+	 * `fundamental_frequency` closest to the default carrier frequency,
+	 * without going below the minimum frequency of the device tree. The
+	 * switching pattern then repeats identically on each fundamental
+	 * period and is the same on the three phases, so duty cycles can be
+	 * precomputed once per fundamental period.
+	 *
+	 * The carrier period is an integer number of timer ticks: the
+	 * fundamental actually obtained, exactly `ratio` carrier periods, is
+	 * returned by `getSynchronousFundamental()` and should be used to
+	 * compute the reference angle so that it does not drift.
+	 *
+	 * @param fundamental_frequency fundamental frequency in Hz
+	 *
+	 * @return carrier to fundamental ratio, or `0` if
+	 * 		   `fundamental_frequency` is invalid.
+	 *
+	 * @warning The master period changes with the carrier, so a critical task
+	 * 			driven by the HRTIM no longer runs at its initial period:
+	 * 			its period must be multiplied by `getCarrierPeriodScale()`.
+	 */
+	uint16_t setSynchronousPwm(float32_t fundamental_frequency);
+
+	/**
+	 * @brief returns the carrier to fundamental ratio set by
+	 * 		  `setSynchronousPwm`, `0` when running asynchronous PWM.
+	 */
+	uint16_t getSynchronousRatio();
+
+	/**
+	 * @brief returns the fundamental frequency obtained by
+	 * 		  `setSynchronousPwm`, in Hz, `0` when running asynchronous PWM.
+	 */
+	float32_t getSynchronousFundamental();
+
+	/**
+	 * @brief returns the ratio of the current carrier period to the
+	 * 		  period at the default carrier frequency.
+	 *
+	 * A critical task driven by the HRTIM runs at its initial period
+	 * multiplied by this ratio, e.g. to rescale `T_control`.
+	 */
+	float32_t getCarrierPeriodScale();
+
 
 	/**
 	 * @brief Sets ADC decimator for a leg
@@ -304,6 +487,74 @@ public:
 	 */
 	void setAdcDecim(leg_t leg, uint16_t adc_decim);
 
+	/**
+	 * @brief Sets the number of ADC samples taken for a leg in each
+	 * 		  PWM period.
+	 *
+	 * With 2 samples, the ADC of the leg is triggered on both the rising
+	 * and falling edges of the carrier, and the ADC is configured to
+	 * average the two acquisitions: the control task still gets one value
+	 * per period, with less noise and no additional filter delay.
+	 * Discontinuous mode is then disabled on that ADC so that each edge
+	 * converts the whole sequence of enabled channels: the sequence
+	 * conversion time must fit in half a PWM period.
+	 *
+	 * @param leg leg for which to set the sample count: `LEG1` to `ALL`
+	 * @param samples_count `1` (default) or `2`
+	 *
+	 * @return `0` on success, `-1` if the count is invalid, a leg is not
+	 * 		   in center-aligned modulation, the ADC sequence of a leg
+	 * 		   takes longer than half the carrier period or data
+	 * 		   acquisition is already started. No leg is configured
+	 * 		   on error.
+	 *
+	 * @warning This function must be called AFTER initializing the leg and
+	 * 			enabling the sensors, and BEFORE starting data acquisition
+	 * 			or the critical task. Configuring discontinuous mode again
+	 * 			afterwards would mix acquisitions of different edges.
+	 */
+	int8_t setAdcSamplesPerPeriod(leg_t leg, uint8_t samples_count);
+
+	/**
+	 * @brief Initialise a leg for peak current mode control.
+	 *
+	 * The leg is initialized in buck topology with `CURRENT_MODE`: at each
+	 * PWM period, the switch is turned off as soon as the leg current
+	 * measured by the comparator reaches the peak current reference,
+	 * which gives cycle-by-cycle current limiting. The duty cycle set by
+	 * `setDutyCycle()` is then the maximum on-time.
+	 *
+	 * @param leg Leg to initialize: `LEG1` to `LEG5`. Only legs with a
+	 * 			  comparator in the device tree support it, e.g. `LEG1` and
+	 * 			  `LEG2` for the Twist and OwnVerter boards.
+	 * @param current_sensor Sensor measuring the leg current, e.g. `I1_LOW`.
+	 * 						 Its linear conversion parameters are used to
+	 * 						 convert references to comparator voltages.
+	 * @param slope_current Slope compensation: the reference decreases by
+	 * 						this amount, in A, over one PWM period.
+	 *
+	 * @return `0` on success, `-1` if the leg has no comparator or the
+	 * 		   sensor is not enabled with a positive linear gain.
+	 *
+	 * @note  The sensor must be enabled before calling this function.
+	 */
+	int8_t initPeakCurrentMode(leg_t leg,
+							   sensor_t current_sensor,
+							   float32_t slope_current = 0.0F);
+
+	/**
+	 * @brief Set the peak current reference of a leg in peak current mode.
+	 *
+	 * Meant to be called at each control task tick. The comparator scale
+	 * derived from the sensor conversion parameters is cached, and only
+	 * derived again after these parameters change, e.g. by a calibration.
+	 *
+	 * @param leg Leg to update: `LEG1` to `ALL`. Legs not initialized with
+	 * 			  `initPeakCurrentMode()` are ignored.
+	 * @param peak_current Peak current reference in A.
+	 */
+	void setPeakCurrent(leg_t leg, float32_t peak_current);
+
 	/**
 	 * @brief Initialise a leg for buck topology
 	 *
@@ -27,15 +27,24 @@
 
 /* Stdlib */
 #include <stdlib.h>
+#include <string.h>
 
 /* Zephyr headers */
-#include <zephyr/console/console.h>
+#include <zephyr/kernel.h>
+
+/* OwnTech drivers */
+#include "console_input.h"
+#include "nvs_storage.h"
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+#include "retained_state.h"
+#endif
 
 /* Current class header */
 #include "Sensors.h"
 
 /* Other modules public API */
 #include "SpinAPI.h"
+#include "ShieldAPI.h"
 
 /**
  *  Device-tree related macros
@@ -127,6 +136,11 @@ uint8_t SensorsAPI::available_sensors_count[ADC_COUNT] = {0};
  */
 SensorsAPI::sensor_dt_data_t** SensorsAPI::available_sensors_props[ADC_COUNT] = {0};
 
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+/* Storage for the channels lists of all ADCs */
+SensorsAPI::sensor_dt_data_t* SensorsAPI::available_sensors_storage[DT_SENSORS_COUNT] = {0};
+#endif
+
 /** List of sensors enabled by user configuration.
  * For each sensor, a nullptr indicates it has not been
  * enabled, and a valid pointer will point to the structure
@@ -136,6 +150,236 @@ SensorsAPI::sensor_dt_data_t* SensorsAPI::enabled_sensors[DT_SENSORS_COUNT] = {0
 
 bool SensorsAPI::initialized = false;
 
+/**
+ * Calibration profile: NVS storage versioned record, whose entries are:
+ * - 1 byte ADC number
+ * - 1 byte channel number
+ * - 1 byte conversion type
+ * - 1 byte number of conversion parameters
+ * - Array of conversion parameters, each using 4 bytes.
+ */
+static const uint16_t CALIBRATION_PROFILE_SCHEMA_VERSION = 0x0001;
+static const uint8_t  CALIBRATION_PROFILE_COUNT          = 16;
+static const uint8_t  CALIBRATION_PROFILE_HEADER_SIZE    =
+										NVS_STORAGE_RECORD_HEADER_SIZE;
+static const uint8_t  CALIBRATION_ENTRY_HEADER_SIZE      = 4;
+static const uint8_t  CALIBRATION_ENTRY_MAX_PARAMETERS   = 4;
+static const uint8_t  CALIBRATION_CHANNEL_MAX            = 31;
+
+static const uint16_t CALIBRATION_PROFILE_MAX_SIZE =
+					CALIBRATION_PROFILE_HEADER_SIZE +
+					DT_SENSORS_COUNT * (CALIBRATION_ENTRY_HEADER_SIZE +
+										4 * CALIBRATION_ENTRY_MAX_PARAMETERS);
+
+/* Virtual sensors, computed as a linear combination of other sensors */
+static const uint8_t VIRTUAL_SENSOR_MAX_SOURCES = 4;
+
+typedef struct
+{
+	uint8_t   sources_count;
+	sensor_t  sources[VIRTUAL_SENSOR_MAX_SOURCES];
+	float32_t coefficients[VIRTUAL_SENSOR_MAX_SOURCES];
+	float32_t constant;
+} virtual_sensor_t;
+
+static virtual_sensor_t virtual_sensors[DT_SENSORS_COUNT] = {0};
+
+/**
+ * Published snapshot, protected by a sequence counter: odd while
+ * values are being written, incremented by 2 on each publication.
+ */
+static const uint8_t SNAPSHOT_READ_ATTEMPTS = 4;
+
+static volatile uint32_t snapshot_sequence = 0;
+static float32_t snapshot_values[SENSORS_SNAPSHOT_SIZE];
+
+/* Latest values returned by getLatestValue(), to be published */
+static float32_t read_values[SENSORS_SNAPSHOT_SIZE];
+static bool      read_values_valid[SENSORS_SNAPSHOT_SIZE] = {false};
+
+/* Offset calibration sampling, bounded to one second */
+static const uint16_t OFFSET_CALIBRATION_PERIOD_US  = 500;
+static const uint16_t OFFSET_CALIBRATION_TIMEOUT_MS = 1000;
+
+/* Channels set by the last loaded profile, one bit per channel for each ADC */
+static uint32_t profile_channels[ADC_COUNT] = {0};
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+static uint8_t calibration_profile_buffer[CALIBRATION_PROFILE_MAX_SIZE];
+#endif
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+/* Parameters in use, restored after a warm boot instead of reading NVS */
+static struct
+{
+	uint16_t size;
+	uint8_t  profile[CALIBRATION_PROFILE_MAX_SIZE];
+} retained_calibration;
+#endif
+
+/**
+ * Number of conversion parameters for a conversion type,
+ * 0 for unknown types.
+ */
+static uint8_t _sensors_get_parameters_count(uint8_t conversion_type)
+{
+	switch (conversion_type)
+	{
+		case conversion_linear:
+			return 2;
+		case conversion_therm:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Check a profile record.
+ * Returns 0 if valid, -1 if size is invalid, -2 if schema
+ * version differs, -3 if data is corrupted.
+ */
+static int8_t _sensors_check_profile(uint8_t* buffer, int16_t size)
+{
+	if (size > CALIBRATION_PROFILE_MAX_SIZE)
+	{
+		return -1;
+	}
+
+	int8_t ret = nvs_storage_record_check(buffer,
+										  size,
+										  CALIBRATION_PROFILE_SCHEMA_VERSION);
+	if (ret != 0)
+	{
+		return ret;
+	}
+
+	uint8_t  entries_count = nvs_storage_record_get_entries_count(buffer);
+	uint16_t entry = CALIBRATION_PROFILE_HEADER_SIZE;
+	for (uint8_t i = 0 ; i < entries_count ; i++)
+	{
+		if (entry + CALIBRATION_ENTRY_HEADER_SIZE > size)
+		{
+			return -3;
+		}
+
+		uint8_t parameters_count =
+			_sensors_get_parameters_count(buffer[entry + 2]);
+
+		if ( (buffer[entry] == 0) || (buffer[entry] > ADC_COUNT) ||
+			 (buffer[entry + 1] == 0) ||
+			 (buffer[entry + 1] > CALIBRATION_CHANNEL_MAX) ||
+			 (parameters_count == 0) ||
+			 (parameters_count != buffer[entry + 3]) )
+		{
+			return -3;
+		}
+
+		entry += CALIBRATION_ENTRY_HEADER_SIZE + 4*parameters_count;
+	}
+
+	if (entry != size)
+	{
+		return -3;
+	}
+
+	return 0;
+}
+
+/**
+ * Size of the profile entry starting at entry.
+ */
+static uint16_t _sensors_get_profile_entry_size(const uint8_t* entry)
+{
+	return CALIBRATION_ENTRY_HEADER_SIZE + 4*entry[3];
+}
+
+/**
+ * Offset of the entry of a channel in a valid profile record,
+ * 0 if the profile has no entry for this channel.
+ */
+static uint16_t _sensors_find_profile_entry(const uint8_t* buffer,
+											uint8_t adc_num,
+											uint8_t channel_num)
+{
+	uint16_t entry = CALIBRATION_PROFILE_HEADER_SIZE;
+	uint8_t entries_count = nvs_storage_record_get_entries_count(buffer);
+	for (uint8_t i = 0 ; i < entries_count ; i++)
+	{
+		if ( (buffer[entry] == adc_num) && (buffer[entry + 1] == channel_num) )
+		{
+			return entry;
+		}
+
+		entry += _sensors_get_profile_entry_size(&buffer[entry]);
+	}
+
+	return 0;
+}
+
+/**
+ * Write the current parameters of a channel as a profile entry.
+ * Returns the entry size, 0 if the channel has no known conversion.
+ */
+static uint16_t _sensors_write_profile_entry(uint8_t* entry,
+											 uint8_t adc_num,
+											 uint8_t channel_num)
+{
+	conversion_type_t conversion_type =
+		data_conversion_get_conversion_type(adc_num, channel_num);
+
+	uint8_t parameters_count = _sensors_get_parameters_count(conversion_type);
+
+	if (parameters_count == 0)
+	{
+		return 0;
+	}
+
+	entry[0] = adc_num;
+	entry[1] = channel_num;
+	entry[2] = conversion_type;
+	entry[3] = parameters_count;
+
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		float32_t parameter =
+			data_conversion_get_parameter(adc_num, channel_num, i + 1);
+
+		memcpy(&entry[CALIBRATION_ENTRY_HEADER_SIZE + 4*i], &parameter, 4);
+	}
+
+	return _sensors_get_profile_entry_size(entry);
+}
+
+/**
+ * Apply the parameters of a profile entry to its channel.
+ */
+static void _sensors_apply_profile_entry(const uint8_t* entry)
+{
+	uint8_t adc_num     = entry[0];
+	uint8_t channel_num = entry[1];
+
+	float32_t parameters[CALIBRATION_ENTRY_MAX_PARAMETERS];
+	memcpy(parameters, &entry[CALIBRATION_ENTRY_HEADER_SIZE], 4*entry[3]);
+
+	if (entry[2] == conversion_linear)
+	{
+		data_conversion_set_conversion_parameters_linear(
+			adc_num, channel_num,
+			parameters[0], parameters[1]
+		);
+	}
+	else
+	{
+		data_conversion_set_conversion_parameters_therm(
+			adc_num, channel_num,
+			parameters[0], parameters[1], parameters[2], parameters[3]
+		);
+	}
+
+	profile_channels[adc_num - 1] |= 1U << channel_num;
+}
+
 
 /**
  *  Public functions accessible only when using a power shield
@@ -180,6 +424,52 @@ int8_t SensorsAPI::enableSensor(sensor_t sensor_name, adc_t adc_num)
 	return DataAPI::enableChannel(sensor_info.adc_num, sensor_info.channel_num);
 }
 
+int8_t SensorsAPI::enableVirtualSensor(sensor_t sensor_name,
+									   const sensor_t* sources,
+									   const float32_t* coefficients,
+									   uint8_t sources_count,
+									   float32_t constant)
+{
+	if (initialized == false)
+	{
+		buildSensorListFromDeviceTree();
+	}
+
+	/* Check parameters */
+	if (sensor_name == UNDEFINED_SENSOR) return ERROR_CHANNEL_NOT_FOUND;
+	if ( (sources == nullptr) || (coefficients == nullptr) ||
+		 (sources_count == 0) ||
+		 (sources_count > VIRTUAL_SENSOR_MAX_SOURCES) )
+	{
+		return ERROR_CHANNEL_NOT_FOUND;
+	}
+
+	int sensor_index = ((int)sensor_name) - 1;
+	if (enabled_sensors[sensor_index] != nullptr) return ERROR_CHANNEL_NOT_FOUND;
+
+	for (uint8_t i = 0 ; i < sources_count ; i++)
+	{
+		if ( (sources[i] == UNDEFINED_SENSOR) ||
+			 (enabled_sensors[((int)sources[i]) - 1] == nullptr) )
+		{
+			return ERROR_CHANNEL_NOT_FOUND;
+		}
+	}
+
+	/* Register virtual sensor */
+	virtual_sensor_t* virtual_sensor = &virtual_sensors[sensor_index];
+
+	for (uint8_t i = 0 ; i < sources_count ; i++)
+	{
+		virtual_sensor->sources[i]      = sources[i];
+		virtual_sensor->coefficients[i] = coefficients[i];
+	}
+	virtual_sensor->constant      = constant;
+	virtual_sensor->sources_count = sources_count;
+
+	return 0;
+}
+
 uint16_t* SensorsAPI::getRawValues(sensor_t sensor_name,
 								   uint32_t& number_of_values_acquired)
 {
@@ -202,6 +492,12 @@ float32_t* SensorsAPI::getValues(sensor_t sensor_name,
 
 float32_t SensorsAPI::peekLatestValue(sensor_t sensor_name)
 {
+	if ( (sensor_name != UNDEFINED_SENSOR) &&
+		 (virtual_sensors[((int)sensor_name) - 1].sources_count > 0) )
+	{
+		return getVirtualSensorValue(sensor_name);
+	}
+
 	sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
 
 	return DataAPI::peekChannel(sensor_info.adc_num,
@@ -210,11 +506,99 @@ float32_t SensorsAPI::peekLatestValue(sensor_t sensor_name)
 
 float32_t SensorsAPI::getLatestValue(sensor_t sensor_name, uint8_t* dataValid)
 {
-	sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
+	if (sensor_name == UNDEFINED_SENSOR)
+	{
+		sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
 
-	return DataAPI::getChannelLatest(sensor_info.adc_num,
-									 sensor_info.channel_num,
-									 dataValid);
+		return DataAPI::getChannelLatest(sensor_info.adc_num,
+										 sensor_info.channel_num,
+										 dataValid);
+	}
+
+	int sensor_index = ((int)sensor_name) - 1;
+	float32_t value;
+
+	if (virtual_sensors[sensor_index].sources_count > 0)
+	{
+		value = getVirtualSensorValue(sensor_name, dataValid);
+	}
+	else
+	{
+		sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
+
+		value = DataAPI::getChannelLatest(sensor_info.adc_num,
+										  sensor_info.channel_num,
+										  dataValid);
+	}
+
+	/* Keep the value for the next snapshot */
+	if (value != NO_VALUE)
+	{
+		read_values[sensor_index]       = value;
+		read_values_valid[sensor_index] = true;
+	}
+
+	return value;
+}
+
+void SensorsAPI::publishSnapshot()
+{
+	uint32_t sequence = snapshot_sequence;
+
+	snapshot_sequence = sequence + 1;
+	compiler_barrier();
+
+	/* Only copy values already read: no acquisition or conversion here */
+	for (int sensor_index = 0 ;
+		 sensor_index < SENSORS_SNAPSHOT_SIZE ;
+		 sensor_index++)
+	{
+		snapshot_values[sensor_index] = read_values_valid[sensor_index] ?
+										read_values[sensor_index] : NO_VALUE;
+	}
+
+	compiler_barrier();
+
+	/* 0 is kept to tell that nothing was published */
+	sequence += 2;
+	if (sequence == 0)
+	{
+		sequence = 2;
+	}
+	snapshot_sequence = sequence;
+}
+
+int8_t SensorsAPI::readSnapshot(sensors_snapshot_t& snapshot)
+{
+	for (uint8_t attempt = 0 ; attempt < SNAPSHOT_READ_ATTEMPTS ; attempt++)
+	{
+		uint32_t sequence = snapshot_sequence;
+
+		if (sequence == 0)
+		{
+			/* Nothing published yet */
+			return -1;
+		}
+
+		if ((sequence & 1) != 0)
+		{
+			/* Publication in progress */
+			k_yield();
+			continue;
+		}
+
+		compiler_barrier();
+		memcpy(snapshot.values, snapshot_values, sizeof(snapshot_values));
+		compiler_barrier();
+
+		if (snapshot_sequence == sequence)
+		{
+			snapshot.version = sequence / 2;
+			return 0;
+		}
+	}
+
+	return -1;
 }
 
 float32_t SensorsAPI::convertRawValue(sensor_t sensor_name, uint16_t raw_value)
@@ -242,6 +626,10 @@ void SensorsAPI::setConversionParametersLinear(sensor_t sensor_name,
 			gain,
 			offset
 		);
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+		updateRetainedCalibration();
+#endif
 	}
 }
 
@@ -264,6 +652,10 @@ void SensorsAPI::setConversionParametersNtcThermistor(sensor_t sensor_name,
 			rdiv,
 			t0
 		);
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+		updateRetainedCalibration();
+#endif
 	}
 }
 
@@ -290,24 +682,312 @@ int8_t SensorsAPI::retrieveParametersFromMemory(sensor_t sensor_name)
 {
 	sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
 
-	return data_conversion_retrieve_channel_parameters_from_nvs(
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	uint8_t* buffer = calibration_profile_buffer;
+#else
+	uint8_t* buffer = (uint8_t*)k_malloc(CALIBRATION_PROFILE_MAX_SIZE);
+	if (buffer == nullptr)
+	{
+		return -1;
+	}
+#endif
+
+	/* Profile 0 is what is loaded at boot: it comes first */
+	int16_t size = nvs_storage_retrieve_data(CALIBRATION_PROFILE | 0,
+											 buffer,
+											 CALIBRATION_PROFILE_MAX_SIZE);
+
+	uint16_t entry = 0;
+	if (_sensors_check_profile(buffer, size) == 0)
+	{
+		entry = _sensors_find_profile_entry(buffer,
+											sensor_info.adc_num,
+											sensor_info.channel_num);
+	}
+
+	int8_t ret;
+	if (entry != 0)
+	{
+		_sensors_apply_profile_entry(&buffer[entry]);
+		ret = 0;
+	}
+	else
+	{
+		/* Parameters stored before calibration profiles */
+		ret = data_conversion_retrieve_channel_parameters_from_nvs(
 				sensor_info.adc_num,
 				sensor_info.channel_num
-			);
+			  );
+	}
+
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
+	k_free(buffer);
+#endif
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	if (ret == 0)
+	{
+		updateRetainedCalibration();
+	}
+#endif
+
+	return ret;
 }
 
 int8_t SensorsAPI::storeParametersInMemory(sensor_t sensor_name)
 {
 	sensor_info_t sensor_info = getEnabledSensorInfo(sensor_name);
-	return data_conversion_store_channel_parameters_in_nvs(
-				sensor_info.adc_num,
-				sensor_info.channel_num
-			);
+
+	if (sensor_info.adc_num <= DEFAULT_ADC)
+	{
+		return -1;
+	}
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	uint8_t* buffer = calibration_profile_buffer;
+#else
+	uint8_t* buffer = (uint8_t*)k_malloc(CALIBRATION_PROFILE_MAX_SIZE);
+	if (buffer == nullptr)
+	{
+		return -1;
+	}
+#endif
+
+	/**
+	 * Profile 0 takes precedence over per-channel records at boot:
+	 * the sensor entry is updated in it, other entries are kept.
+	 */
+	int16_t size = nvs_storage_retrieve_data(CALIBRATION_PROFILE | 0,
+											 buffer,
+											 CALIBRATION_PROFILE_MAX_SIZE);
+
+	uint8_t entries_count = 0;
+	uint16_t entry = 0;
+	if (_sensors_check_profile(buffer, size) == 0)
+	{
+		entries_count = nvs_storage_record_get_entries_count(buffer);
+		entry = _sensors_find_profile_entry(buffer,
+											sensor_info.adc_num,
+											sensor_info.channel_num);
+	}
+	else
+	{
+		size = CALIBRATION_PROFILE_HEADER_SIZE;
+	}
+
+	if (entry != 0)
+	{
+		uint16_t entry_size = _sensors_get_profile_entry_size(&buffer[entry]);
+		memmove(&buffer[entry],
+				&buffer[entry + entry_size],
+				size - (entry + entry_size));
+		size -= entry_size;
+		entries_count--;
+	}
+
+	int8_t ret = -1;
+	uint16_t entry_max_size = CALIBRATION_ENTRY_HEADER_SIZE +
+							  4 * CALIBRATION_ENTRY_MAX_PARAMETERS;
+	if (size + entry_max_size <= CALIBRATION_PROFILE_MAX_SIZE)
+	{
+		uint16_t entry_size =
+			_sensors_write_profile_entry(&buffer[size],
+										 sensor_info.adc_num,
+										 sensor_info.channel_num);
+		if (entry_size != 0)
+		{
+			size += entry_size;
+			entries_count++;
+
+			nvs_storage_record_seal(buffer,
+									size,
+									CALIBRATION_PROFILE_SCHEMA_VERSION,
+									entries_count);
+
+			int16_t rc = nvs_storage_store_data(CALIBRATION_PROFILE | 0,
+												buffer,
+												size);
+			ret = (rc < 0) ? -1 : 0;
+		}
+	}
+
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
+	k_free(buffer);
+#endif
+
+	return ret;
+}
+
+int8_t SensorsAPI::storeCalibrationProfile(uint8_t profile)
+{
+	if (profile >= CALIBRATION_PROFILE_COUNT)
+	{
+		return -1;
+	}
+
+	if (initialized == false)
+	{
+		buildSensorListFromDeviceTree();
+	}
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	uint8_t* buffer = calibration_profile_buffer;
+#else
+	uint8_t* buffer = (uint8_t*)k_malloc(CALIBRATION_PROFILE_MAX_SIZE);
+	if (buffer == nullptr)
+	{
+		return -1;
+	}
+#endif
+
+	uint16_t size = buildCalibrationProfile(buffer);
+
+	int16_t rc = nvs_storage_store_data(CALIBRATION_PROFILE | profile,
+										buffer,
+										size);
+
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
+	k_free(buffer);
+#endif
+
+	return (rc < 0) ? -1 : 0;
+}
+
+int8_t SensorsAPI::loadCalibrationProfile(uint8_t profile)
+{
+	if (profile >= CALIBRATION_PROFILE_COUNT)
+	{
+		return -1;
+	}
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	uint8_t* buffer = calibration_profile_buffer;
+#else
+	uint8_t* buffer = (uint8_t*)k_malloc(CALIBRATION_PROFILE_MAX_SIZE);
+	if (buffer == nullptr)
+	{
+		return -1;
+	}
+#endif
+
+	int16_t size = nvs_storage_retrieve_data(CALIBRATION_PROFILE | profile,
+											 buffer,
+											 CALIBRATION_PROFILE_MAX_SIZE);
+
+	int8_t ret = applyCalibrationProfile(buffer, size);
+
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
+	k_free(buffer);
+#endif
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	if ( (ret == 0) && (initialized == true) )
+	{
+		updateRetainedCalibration();
+	}
+#endif
+
+	return ret;
+}
+
+int8_t SensorsAPI::calibrateOffsets(const sensor_t* sensors,
+									uint8_t sensors_count,
+									uint16_t samples_count,
+									bool store)
+{
+	if ( (sensors == nullptr) || (sensors_count == 0) ||
+		 (sensors_count > DT_SENSORS_COUNT) || (samples_count == 0) )
+	{
+		return -1;
+	}
+
+	for (uint8_t i = 0 ; i < sensors_count ; i++)
+	{
+		sensor_info_t sensor_info = getEnabledSensorInfo(sensors[i]);
+
+		if ( (sensor_info.channel_num == 0) ||
+			 (retrieveStoredConversionType(sensors[i]) != conversion_linear) )
+		{
+			return -1;
+		}
+	}
+
+	/* Sensors would not measure a zero value */
+	if (shield.power.isStarted(ALL) == true)
+	{
+		return -4;
+	}
+
+	float32_t sums[DT_SENSORS_COUNT]  = {0};
+	uint16_t counts[DT_SENSORS_COUNT] = {0};
+	uint16_t complete_count = 0;
+
+	uint32_t max_iterations =
+		(OFFSET_CALIBRATION_TIMEOUT_MS * 1000) / OFFSET_CALIBRATION_PERIOD_US;
+
+	for (uint32_t iteration = 0 ;
+		 (iteration < max_iterations) && (complete_count < sensors_count) ;
+		 iteration++)
+	{
+		for (uint8_t i = 0 ; i < sensors_count ; i++)
+		{
+			if (counts[i] >= samples_count)
+			{
+				continue;
+			}
+
+			/* Nothing is acquired before the first ADC trigger */
+			float32_t value = peekLatestValue(sensors[i]);
+			if (value == NO_VALUE)
+			{
+				continue;
+			}
+
+			sums[i] += value;
+			counts[i]++;
+
+			if (counts[i] == samples_count)
+			{
+				complete_count++;
+			}
+		}
+
+		k_usleep(OFFSET_CALIBRATION_PERIOD_US);
+	}
+
+	if (complete_count < sensors_count)
+	{
+		return -2;
+	}
+
+	for (uint8_t i = 0 ; i < sensors_count ; i++)
+	{
+		float32_t sensor_gain   =
+			retrieveStoredParameterValue(sensors[i], gain);
+		float32_t sensor_offset =
+			retrieveStoredParameterValue(sensors[i], offset);
+
+		/* Average value is gain * raw + offset, and must become 0 */
+		setConversionParametersLinear(sensors[i],
+									  sensor_gain,
+									  sensor_offset - sums[i] / samples_count);
+	}
+
+	if (store == true)
+	{
+		if ( (storeCalibrationProfile(0) != 0) ||
+			 (nvs_storage_flush() != 0) )
+		{
+			return -3;
+		}
+	}
+
+	return 0;
 }
 
 #ifdef CONFIG_SHIELD_OWNVERTER
 
-void SensorsAPI::enableDefaultOwnverterSensors()
+void SensorsAPI::enableDefaultOwnverterSensors(bool virtual_i3)
 {
 	/**
 	 * Defines the triggers of all ADCs.
@@ -334,7 +1014,10 @@ void SensorsAPI::enableDefaultOwnverterSensors()
 	/* Creates the list of measurements of the ADC 1 */
 	this->enableSensor(V1_LOW, ADC_1);
 	this->enableSensor(V2_LOW, ADC_1);
-	this->enableSensor(I3_LOW, ADC_1);
+	if (virtual_i3 == false)
+	{
+		this->enableSensor(I3_LOW, ADC_1);
+	}
 	this->enableSensor(V_HIGH, ADC_1);
 	this->enableSensor(V_NEUTR, ADC_1);
 
@@ -345,6 +1028,14 @@ void SensorsAPI::enableDefaultOwnverterSensors()
 	this->enableSensor(I_HIGH, ADC_2);
 	this->enableSensor(TEMP_SENSOR, ADC_2);
 
+	/* With a three-wire load, phase currents sum to zero */
+	if (virtual_i3 == true)
+	{
+		const sensor_t phase_currents[] = {I1_LOW, I2_LOW};
+		const float32_t coefficients[]  = {-1, -1};
+		this->enableVirtualSensor(I3_LOW, phase_currents, coefficients, 2);
+	}
+
 	/* Configure the pins of the temperature MUX */
 	spin.gpio.configurePin(temp_mux_in_1,OUTPUT);
 	spin.gpio.configurePin(temp_mux_in_2,OUTPUT);
@@ -549,56 +1240,12 @@ void SensorsAPI::setTwistSensorsUserCalibrationFactors()
 	printk("Press y to store parameters in permanent storage, "
 		   "any other key to don't store them.\n");
 
-	char received_char = console_getchar();
+	char received_char = console_input_getchar();
 	if (received_char == 'y')
 	{
-		sensor_info = getEnabledSensorInfo(V_HIGH);
-		int8_t err = data_conversion_store_channel_parameters_in_nvs(
-						sensor_info.adc_num,
-						sensor_info.channel_num
-					 );
-
-		sensor_info = getEnabledSensorInfo(V1_LOW);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(V2_LOW);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(I_HIGH);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(I1_LOW);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(I2_LOW);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(TEMP_SENSOR_1);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
-
-		sensor_info = getEnabledSensorInfo(TEMP_SENSOR_2);
-		err |= data_conversion_store_channel_parameters_in_nvs(
-					sensor_info.adc_num,
-					sensor_info.channel_num
-				);
+		/* All channels are written in a single record */
+		int8_t err = storeCalibrationProfile();
+		err |= nvs_storage_flush();
 
 		if (err == 0)
 		{
@@ -620,6 +1267,39 @@ void SensorsAPI::setTwistSensorsUserCalibrationFactors()
 
 
 
+float32_t SensorsAPI::getVirtualSensorValue(sensor_t sensor_name,
+											 uint8_t* dataValid)
+{
+	virtual_sensor_t* virtual_sensor =
+						&virtual_sensors[((int)sensor_name) - 1];
+
+	float32_t value = virtual_sensor->constant;
+
+	for (uint8_t i = 0 ; i < virtual_sensor->sources_count ; i++)
+	{
+		/* Sources buffers are left to their own readers */
+		float32_t source_value = peekLatestValue(virtual_sensor->sources[i]);
+
+		if (source_value == NO_VALUE)
+		{
+			if (dataValid != nullptr)
+			{
+				*dataValid = DATA_IS_MISSING;
+			}
+			return NO_VALUE;
+		}
+
+		value += virtual_sensor->coefficients[i] * source_value;
+	}
+
+	if (dataValid != nullptr)
+	{
+		*dataValid = DATA_IS_OK;
+	}
+
+	return value;
+}
+
 sensor_info_t SensorsAPI::getEnabledSensorInfo(sensor_t sensor_name)
 {
 	if (initialized == false)
@@ -644,6 +1324,29 @@ sensor_info_t SensorsAPI::getEnabledSensorInfo(sensor_t sensor_name)
 void SensorsAPI::buildSensorListFromDeviceTree()
 {
 	bool checkNvs = true;
+	bool calibrationRestored = false;
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	/* After a warm boot, parameters in use before the reset are restored */
+	if (retained_state_register(RETAINED_STATE_ID_SENSORS,
+								&retained_calibration,
+								sizeof(retained_calibration)) == 1)
+	{
+		calibrationRestored =
+			(applyCalibrationProfile(retained_calibration.profile,
+									 retained_calibration.size) == 0);
+	}
+#endif
+
+	if (calibrationRestored == true)
+	{
+		printk("Calibration has been restored from retained memory\n");
+	}
+	/* Calibration profile 0 holds all channels in a single record */
+	else if (loadCalibrationProfile(0) == 0)
+	{
+		printk("Calibration profile has been retrieved from flash\n");
+	}
 
 	/* Retrieve calibration coefficients for each sensor listed in device tree */
 	for (uint8_t dt_sensor_index = 0 ;
@@ -676,7 +1379,15 @@ void SensorsAPI::buildSensorListFromDeviceTree()
 
 		/* Get parameters from NVS if they exist */
 		bool nvsRetrieved = false;
-		if (checkNvs == true)
+		uint32_t profile_channel_mask =
+			profile_channels[dt_sensors_props[dt_sensor_index].adc_number - 1];
+		if ( (profile_channel_mask &
+			  (1U << dt_sensors_props[dt_sensor_index].channel_number)) != 0 )
+		{
+			/* Already set by the calibration profile */
+			nvsRetrieved = true;
+		}
+		else if (checkNvs == true)
 		{
 			int8_t res = data_conversion_retrieve_channel_parameters_from_nvs(
 							dt_sensors_props[dt_sensor_index].adc_number,
@@ -834,11 +1545,21 @@ void SensorsAPI::buildSensorListFromDeviceTree()
 	}
 
 	/* Create the channels list for each ADC */
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	uint8_t sensors_offset = 0;
+#endif
 	for (uint8_t adc_index = 0 ; adc_index < ADC_COUNT ; adc_index++)
 	{
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+		available_sensors_props[adc_index] =
+			&available_sensors_storage[sensors_offset];
+
+		sensors_offset += available_sensors_count[adc_index];
+#else
 		available_sensors_props[adc_index] =
 			(sensor_dt_data_t**)k_malloc(sizeof(sensor_dt_data_t*) *
 										available_sensors_count[adc_index]);
+#endif
 	}
 
 	/* Populate the channels list for each ADC */
@@ -860,46 +1581,92 @@ void SensorsAPI::buildSensorListFromDeviceTree()
 	}
 
 	initialized = true;
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	updateRetainedCalibration();
+#endif
 }
 
 
-void SensorsAPI::getLineFromConsole(char* buffer, uint8_t buffer_size)
+uint16_t SensorsAPI::buildCalibrationProfile(uint8_t* buffer)
 {
-	/* Initializing variables for eventual loop */
-	uint8_t carcount = 0;
-	char received_char;
+	uint16_t size = CALIBRATION_PROFILE_HEADER_SIZE;
+	uint8_t entries_count = 0;
 
-	do
+	for (uint8_t dt_sensor_index = 0 ;
+		 dt_sensor_index < DT_SENSORS_COUNT ;
+		 dt_sensor_index++)
 	{
-		received_char = console_getchar();
-		buffer[carcount] = received_char;
+		uint8_t adc_num     = dt_sensors_props[dt_sensor_index].adc_number;
+		uint8_t channel_num = dt_sensors_props[dt_sensor_index].channel_number;
 
-		/* Backspace character */
-		if (received_char == 0x08)
+		if (adc_num == 0)
 		{
-			/* To avoid character count being negative */
-			if (carcount>0)
-			{
-				carcount--;
-			}
+			continue;
 		}
-		else
+
+		uint16_t entry_size =
+			_sensors_write_profile_entry(&buffer[size], adc_num, channel_num);
+
+		if (entry_size == 0)
 		{
-			carcount++;
+			continue;
 		}
 
-		/* Echo received char */
-		printk("%c", received_char);
+		size += entry_size;
+		entries_count++;
+	}
+
+	nvs_storage_record_seal(buffer,
+							size,
+							CALIBRATION_PROFILE_SCHEMA_VERSION,
+							entries_count);
+
+	return size;
+}
+
+int8_t SensorsAPI::applyCalibrationProfile(uint8_t* buffer, int16_t size)
+{
+	int8_t ret = _sensors_check_profile(buffer, size);
 
-		if (carcount >= (buffer_size-1))
+	if (ret == 0)
+	{
+		memset(profile_channels, 0, sizeof(profile_channels));
+
+		uint8_t  entries_count = nvs_storage_record_get_entries_count(buffer);
+		uint16_t entry = CALIBRATION_PROFILE_HEADER_SIZE;
+		for (uint8_t i = 0 ; i < entries_count ; i++)
 		{
-			printk("Maximum character allowed reached \n");
-			break;
+			_sensors_apply_profile_entry(&buffer[entry]);
+
+			entry += _sensors_get_profile_entry_size(&buffer[entry]);
 		}
-	/* EOL char : CRLF */
-	} while ((received_char!='\n'));
-	 /* Adding end of tab character to prepare for atof function */
-	buffer[carcount-2] = '\0';
+	}
+
+	return ret;
+}
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+
+void SensorsAPI::updateRetainedCalibration()
+{
+	/* A save interrupting this update is caught by the profile CRC */
+	retained_calibration.size =
+		buildCalibrationProfile(retained_calibration.profile);
+}
+
+#endif /* CONFIG_OWNTECH_RETAINED_STATE_DRIVER */
+
+void SensorsAPI::getLineFromConsole(char* buffer, uint8_t buffer_size)
+{
+	console_input_set_echo(true);
+
+	while (console_input_poll_line(buffer, buffer_size) < 0)
+	{
+		k_msleep(10);
+	}
+
+	console_input_set_echo(false);
 }
 
 float32_t SensorsAPI::getCalibrationCoefficients(const char* physicalParameter,
@@ -49,6 +49,11 @@
 /* Device-tree related macro */
 
 #define SENSOR_TOKEN(node_id) DT_STRING_TOKEN(node_id, sensor_name),
+#define SENSOR_NAME_COUNTER(node_id) +1
+
+/* Number of sensor names, i.e. of values in a sensors snapshot */
+#define SENSORS_SNAPSHOT_SIZE \
+				(0 DT_FOREACH_STATUS_OKAY(shield_sensors, SENSOR_NAME_COUNTER))
 
 
 /* Type definitions */
@@ -73,6 +78,34 @@ struct sensor_info_t
 	uint8_t pin_num;
 };
 
+/**
+ * Latest value of the sensors read by the critical task, as published
+ * with SensorsAPI::publishSnapshot().
+ */
+struct sensors_snapshot_t
+{
+	/**
+	 * @brief Value of a sensor in this snapshot.
+	 *
+	 * @return Latest value of the sensor when the snapshot was published,
+	 *         `NO_VALUE` if the sensor was never read with getLatestValue().
+	 */
+	float32_t get(sensor_t sensor_name) const
+	{
+		if (sensor_name == UNDEFINED_SENSOR)
+		{
+			return NO_VALUE;
+		}
+
+		return this->values[((int)sensor_name) - 1];
+	}
+
+	/* Increases with each publication, so that a new snapshot can be told */
+	uint32_t  version;
+	/* values[i] is the value of sensor i+1 in sensor_t enumeration */
+	float32_t values[SENSORS_SNAPSHOT_SIZE];
+};
+
 #ifdef CONFIG_SHIELD_OWNVERTER
 	typedef enum
 	{
@@ -142,6 +175,36 @@ public:
 	 */
 	int8_t enableSensor(sensor_t sensor_name, adc_t adc_number);
 
+	/**
+	 * @brief This function is used to enable a virtual sensor, whose value
+	 *        is computed from other sensors instead of being acquired:
+	 *
+	 *        `value = constant + sum(coefficients[i] * value of sources[i])`
+	 *
+	 *        For example, with a three-wire load, `I3_LOW` can be computed
+	 *        as `-(I1_LOW + I2_LOW)`, shortening the ADC sequence.
+	 *
+	 * @note  Only peekLatestValue() and getLatestValue() can be used with a
+	 *        virtual sensor. They use the latest value of each source without
+	 *        clearing its buffer.
+	 *
+	 * @param[in] sensor_name   Name of the sensor, which must not be
+	 *                          enabled on an ADC.
+	 * @param[in] sources       Array of the source sensors, which must be
+	 *                          enabled on an ADC.
+	 * @param[in] coefficients  Array of the coefficients of the sources.
+	 * @param[in] sources_count Number of sources, from 1 to 4.
+	 * @param[in] constant      Constant term, in the sensor unit.
+	 *
+	 * @return 0 if the sensor was correctly enabled, negative value
+	 * 		   if there was an error.
+	 */
+	int8_t enableVirtualSensor(sensor_t sensor_name,
+							   const sensor_t* sources,
+							   const float32_t* coefficients,
+							   uint8_t sources_count,
+							   float32_t constant = 0);
+
 	/**
 	 * @brief Function to access the acquired data for specified sensor.
 	 * 
@@ -299,6 +362,38 @@ public:
 	 */
 	float32_t getLatestValue(sensor_t sensor_name, uint8_t* dataValid = nullptr);
 
+	/**
+	 * @brief Publish the latest values returned by getLatestValue(),
+	 *        including for virtual sensors, as a new snapshot.
+	 *
+	 *        This function is intended to be called once per period at the
+	 *        end of the critical task, after the sensors have been read with
+	 *        getLatestValue(). It only copies these values: sensors that the
+	 *        task does not read, e.g. temperatures, are not acquired nor
+	 *        converted here and stay `NO_VALUE` in the snapshot.
+	 *
+	 * @note  Only one task may publish snapshots. It must not be interrupted
+	 *        by readSnapshot() callers, which is the case of the critical
+	 *        task relatively to background tasks.
+	 */
+	void publishSnapshot();
+
+	/**
+	 * @brief Copy the latest published snapshot.
+	 *
+	 *        This function can be called from any number of tasks. It does
+	 *        not lock anything and does not touch acquired data: if a new
+	 *        snapshot is published during the copy, the copy is retried,
+	 *        so that all values come from the same period.
+	 *
+	 * @param[out] snapshot Pass a `sensors_snapshot_t` variable, which will
+	 *             be updated with the latest published values.
+	 *
+	 * @return `0` if the snapshot was copied, `-1` if no snapshot has been
+	 *         published yet or no consistent copy could be obtained.
+	 */
+	int8_t readSnapshot(sensors_snapshot_t& snapshot);
+
 	/**
 	 * @brief Use this function to convert values obtained using matching
 	 *        spin.data.get*RawValues() function.
@@ -383,7 +478,13 @@ public:
 	 * @note  This function should be called after updating the parameters
 	 * 		  using setParameters.
 	 *
+	 * @note  Parameters are stored in calibration profile `0`, which is
+	 * 		  loaded at boot: the entry of this sensor is updated, those
+	 * 		  of other sensors are kept.
+	 *
 	 * @param[in] sensor_name Name of the shield sensor to save the values.
+	 *
+	 * @return `0` if parameters were stored, `-1` otherwise.
 	 */
 	int8_t storeParametersInMemory(sensor_t sensor_name);
 
@@ -391,6 +492,10 @@ public:
 	 * @brief Use this function to read the gain and offset parameters
 	 * 		  of the board to is non-volatile memory.
 	 *
+	 *        Parameters are taken from calibration profile `0` when it
+	 *        holds this sensor, from the record written for this channel
+	 *        alone otherwise.
+	 *
 	 * @param[in] sensor_name Name of the shield sensor to save the values.
      * @return `0` if parameters were correctly retrieved,negative value if 
 	 *         there was an error:
@@ -406,6 +511,80 @@ public:
 	 */
 	int8_t retrieveParametersFromMemory(sensor_t sensor_name);
 
+	/**
+	 * @brief Store the conversion parameters of all the sensors defined in
+	 * 		  the device tree as a calibration profile in non-volatile memory.
+	 *
+	 * A profile is a single record with a schema version and a CRC: it is
+	 * written at once, so a power loss can not leave a partial profile.
+	 * Profile `0` is automatically loaded at board boot.
+	 *
+	 * @param[in] profile Profile number, from `0` to `15`.
+	 *
+	 * @return `0` if the profile was stored, `-1` otherwise.
+	 */
+	int8_t storeCalibrationProfile(uint8_t profile = 0);
+
+	/**
+	 * @brief Load a calibration profile from non-volatile memory and apply
+	 * 		  its conversion parameters to all the sensors it contains.
+	 *
+	 * @param[in] profile Profile number, from `0` to `15`.
+	 *
+	 * @return `0` if parameters were applied, negative value if
+	 *         there was an error, in which case no parameter is changed:
+	 * 
+	 * - `-1`: profile not found in NVS
+	 * 
+	 * - `-2`: profile was stored with another schema version
+	 * 
+	 * - `-3`: profile data is corrupted
+	 */
+	int8_t loadCalibrationProfile(uint8_t profile = 0);
+
+	/**
+	 * @brief Automatically calibrate the offset of sensors measuring a
+	 * 		  zero value, typically current sensors with the power stage
+	 * 		  stopped.
+	 *
+	 * The latest acquired value of each sensor is averaged over
+	 * `samples_count` samples, then the offset is corrected so that this
+	 * average converts to 0. Samples are read without consuming acquired
+	 * data, so other tasks can keep reading the sensors meanwhile.
+	 *
+	 * @note  Data acquisition must be running, e.g. by having started the
+	 * 		  critical task. Only sensors with a linear conversion can be
+	 * 		  calibrated.
+	 *
+	 * @param[in] sensors       Array of the sensors to calibrate.
+	 * @param[in] sensors_count Number of sensors in the array.
+	 * @param[in] samples_count Number of samples averaged for each sensor,
+	 *                          a sample being taken every 500 µs.
+	 * @param[in] store         If `true`, all conversion parameters are
+	 *                          then stored as calibration profile `0`.
+	 *
+	 * @return `0` if offsets were calibrated, negative value if
+	 *         there was an error, in which case no offset is changed:
+	 *
+	 * - `-1`: invalid sensor, or sensor not using a linear conversion
+	 *
+	 * - `-2`: not enough values acquired within one second
+	 *
+	 * - `-3`: offsets were calibrated but could not be stored
+	 *
+	 * - `-4`: the power stage is started
+	 *
+	 * @warning Calibration must run with the power stage stopped, before
+	 * 			any task that may start it. If the critical task converts
+	 * 			values on a zero-latency interrupt (TIM6 source), it is not
+	 * 			masked while offsets are updated, and may convert one value
+	 * 			with the previous gain and the new offset.
+	 */
+	int8_t calibrateOffsets(const sensor_t* sensors,
+							uint8_t sensors_count,
+							uint16_t samples_count = 64,
+							bool store = false);
+
 #ifdef CONFIG_SHIELD_OWNVERTER
 
 	/**
@@ -430,9 +609,13 @@ public:
 	 * It also configures the gpios that control the MUX that chooses which
 	 * temperature will be measured.
 	 *
+	 * @param[in] virtual_i3 If `true`, `I3_LOW` is not acquired but computed
+	 *            as `-(I1_LOW + I2_LOW)`, which requires a three-wire load.
+	 *            ADC 1 then only acquires 4 sensors.
+	 *
 	 * @note  This function must be called *before* ADC is started.
 	 */
-	void enableDefaultOwnverterSensors();
+	void enableDefaultOwnverterSensors(bool virtual_i3 = false);
 
 	/**
 	 * @brief This function sets the GPIOs attached to the MUX to control which
@@ -550,6 +733,15 @@ private:
 	 */
 	sensor_info_t getEnabledSensorInfo(sensor_t sensor_name);
 
+	/**
+	 * @brief Compute the value of a virtual sensor from the latest value
+	 *        of its sources.
+	 *
+	 * @return Value of the sensor, or `NO_VALUE` if a source has no value.
+	 */
+	float32_t getVirtualSensorValue(sensor_t sensor_name,
+									uint8_t* dataValid = nullptr);
+
 	/**
 	 * @brief    Builds the list of device-tree defined sensors for each ADC.
 	 */
@@ -566,10 +758,37 @@ private:
 	float32_t getCalibrationCoefficients(const char* physicalParameter,
 										 const char* gainOrOffset);
 
+	/**
+	 * @brief Write the conversion parameters of all the sensors defined in
+	 *        the device tree to a buffer, using the calibration profile
+	 *        record layout.
+	 *
+	 * @return Size of the record in bytes.
+	 */
+	uint16_t buildCalibrationProfile(uint8_t* buffer);
+
+	/**
+	 * @brief Check a calibration profile record and apply its parameters.
+	 *
+	 * @return `0` if parameters were applied, `-1` if size is invalid,
+	 *         `-2` if schema version differs, `-3` if data is corrupted.
+	 */
+	int8_t applyCalibrationProfile(uint8_t* buffer, int16_t size);
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	/**
+	 * @brief Copy the parameters in use to the retained state.
+	 */
+	void updateRetainedCalibration();
+#endif
+
 private:
 	static sensor_dt_data_t dt_sensors_props[];
 	static uint8_t available_sensors_count[ADC_COUNT];
 	static sensor_dt_data_t** available_sensors_props[ADC_COUNT];
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	static sensor_dt_data_t* available_sensors_storage[];
+#endif
 	static sensor_dt_data_t* enabled_sensors[];
 	static bool initialized;
 
@@ -27,6 +27,15 @@
 
 /* Zephyr */
 #include <zephyr/kernel.h>
+#include <zephyr/drivers/dma.h>
+#include <zephyr/drivers/clock_control.h>
+#include <zephyr/drivers/clock_control/stm32_clock_control.h>
+
+/* STM32 LL */
+#include <stm32_ll_bus.h>
+#include <stm32_ll_dac.h>
+#include <stm32_ll_dma.h>
+#include <stm32_ll_tim.h>
 
 /* Owntech drivers */
 #include "dac.h"
@@ -35,16 +44,31 @@
 /* Current file header */
 #include "DacHAL.h"
 
-/**
- * Define the voltage reference used for ADC.
- * It depends on the board used (On nucleo, choose Vref = 2.48V).
- */
-#define VREF 2.048f
-
 static const struct device* dac1 = DEVICE_DT_GET(DAC1_DEVICE);
 static const struct device* dac2 = DEVICE_DT_GET(DAC2_DEVICE);
 static const struct device* dac3 = DEVICE_DT_GET(DAC3_DEVICE);
 
+/* Highest code of the 12-bit DACs */
+#define DAC_CODE_MAX (DAC_RESOLUTION - 1.0f)
+
+static const struct device* dma1 = DEVICE_DT_GET(DT_NODELABEL(dma1));
+
+/* DMA 1 channels 1 to 5 are used by the ADCs, 6 and 7 by RS485 */
+static const uint32_t DAC_WAVEFORM_DMA_CHANNEL = 8;
+
+/**
+ * TIM3, 4, 6 and 7 belong to the timer driver and TIM2 drives the LED:
+ * waveform samples are paced by TIM15.
+ */
+#define DAC_WAVEFORM_TIMER TIM15
+
+DAC_TypeDef* DacHAL::waveform_dac = nullptr;
+bool DacHAL::waveform_timer_triggered = false;
+
+volatile uint32_t* DacHAL::probe_register[DAC_PROBE_COUNT] = {nullptr};
+float32_t DacHAL::probe_gain[DAC_PROBE_COUNT] = {0};
+float32_t DacHAL::probe_offset[DAC_PROBE_COUNT] = {0};
+
 void DacHAL::initConstValue(uint8_t dac_number)
 {
 	const struct device* dac_dev;
@@ -209,20 +233,20 @@ void DacHAL::slopeCompensation(uint8_t dac_number,
 		if (Dv > set_voltage)
 		{
 			Dv = set_voltage;
-			if (Dv > VREF)
-				Dv = VREF;
+			if (Dv > DAC_VREF)
+				Dv = DAC_VREF;
 		}
 
-		uint32_t set_data = (uint32_t)(4096U * set_voltage) / (VREF);
+		uint32_t set_data = (uint32_t)(DAC_RESOLUTION * set_voltage / DAC_VREF);
 
-		if (set_data > 4095U)
-			set_data = 4095U;
+		if (set_data > (uint32_t)DAC_CODE_MAX)
+			set_data = (uint32_t)DAC_CODE_MAX;
 
 	if (dac_number == 1){
 
 		dac_function_update_reset(dac1, 1, set_data);
 		/* Divided by 100 because we have 100 voltage steps */
-		uint32_t reset_data = (uint32_t)(Dv * 65536U) / (VREF * 100);
+		uint32_t reset_data = (uint32_t)(Dv * 65536U) / (DAC_VREF * 100);
 
 		dac_function_update_step(dac1, 1, reset_data);
 	} else if (dac_number == 3){
@@ -230,8 +254,336 @@ void DacHAL::slopeCompensation(uint8_t dac_number,
 
 		dac_function_update_reset(dac3, 1, set_data);
 		/* Divided by 100 because we have 100 voltage steps */
-		uint32_t reset_data = (uint32_t)(Dv * 65536) / (VREF * 100);
+		uint32_t reset_data = (uint32_t)(Dv * 65536) / (DAC_VREF * 100);
 
 		dac_function_update_step(dac3, 1, reset_data);
 	}
 }
+
+int8_t DacHAL::initProbe(uint8_t probe_number,
+						 uint8_t dac_number,
+						 float32_t scale,
+						 float32_t offset)
+{
+	const struct device* dac_dev;
+	DAC_TypeDef* dac_regs;
+
+	if (probe_number >= DAC_PROBE_COUNT)
+	{
+		return -1;
+	}
+
+	/* DAC 3 has no external output */
+	if (dac_number == 1)
+	{
+		dac_dev = dac1;
+		dac_regs = DAC1;
+	}
+	else if (dac_number == 2)
+	{
+		dac_dev = dac2;
+		dac_regs = DAC2;
+	}
+	else
+	{
+		return -1;
+	}
+
+	if (device_is_ready(dac_dev) == false)
+	{
+		return -1;
+	}
+
+	this->initConstValue(dac_number);
+
+	probe_gain[probe_number]   = scale * (DAC_RESOLUTION / DAC_VREF);
+	probe_offset[probe_number] = offset * (DAC_RESOLUTION / DAC_VREF);
+	probe_register[probe_number] = &dac_regs->DHR12R1;
+
+	return 0;
+}
+
+void DacHAL::probe(uint8_t probe_number, float32_t value)
+{
+	if (probe_number >= DAC_PROBE_COUNT)
+	{
+		return;
+	}
+
+	volatile uint32_t* dhr = probe_register[probe_number];
+
+	if (dhr == nullptr)
+	{
+		return;
+	}
+
+	float32_t code = value * probe_gain[probe_number] +
+					 probe_offset[probe_number];
+
+	if (code < 0)
+	{
+		code = 0;
+	}
+	else if (code > DAC_CODE_MAX)
+	{
+		code = DAC_CODE_MAX;
+	}
+
+	*dhr = (uint32_t)code;
+}
+
+/**
+ * Kernel clock of the waveform timer: TIM15 is on APB2, and timers run at
+ * twice the APB clock when the APB prescaler is not 1.
+ * Returns 0 if the clock rate is not available.
+ */
+static uint32_t _dac_waveform_timer_clock()
+{
+	const struct device* clk = DEVICE_DT_GET(STM32_CLOCK_CONTROL_NODE);
+	struct stm32_pclken pclken =
+	{
+		.bus = STM32_CLOCK_BUS_APB2,
+		.enr = LL_APB2_GRP1_PERIPH_TIM15
+	};
+	uint32_t apb_clock = 0;
+
+	if (clock_control_get_rate(clk,
+							   (clock_control_subsys_t)&pclken,
+							   &apb_clock) != 0)
+	{
+		return 0;
+	}
+
+	return (STM32_APB2_PRESCALER == 1) ? apb_clock : apb_clock * 2;
+}
+
+/**
+ * Waveform DMA callback
+ * Interrupts are disabled on the waveform channel: nothing to do.
+ */
+static void _dac_waveform_dma_callback(const struct device* dev,
+									   void* user_data,
+									   uint32_t dma_channel,
+									   int status)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+	ARG_UNUSED(dma_channel);
+	ARG_UNUSED(status);
+}
+
+int8_t DacHAL::startWaveform(uint8_t dac_number,
+							 const uint16_t* table,
+							 uint16_t sample_count,
+							 uint32_t trigger_source)
+{
+	const struct device* dac_dev;
+	DAC_TypeDef* dac_regs;
+	uint32_t dma_slot;
+
+	if ( (table == nullptr) || (sample_count == 0) ||
+		 (waveform_dac != nullptr) || (device_is_ready(dma1) == false) )
+	{
+		return -1;
+	}
+
+	/* DAC 3 has no external output */
+	if (dac_number == 1)
+	{
+		dac_dev  = dac1;
+		dac_regs = DAC1;
+		dma_slot = LL_DMAMUX_REQ_DAC1_CH1;
+	}
+	else if (dac_number == 2)
+	{
+		dac_dev  = dac2;
+		dac_regs = DAC2;
+		dma_slot = LL_DMAMUX_REQ_DAC2_CH1;
+	}
+	else
+	{
+		return -1;
+	}
+
+	if (device_is_ready(dac_dev) == false)
+	{
+		return -1;
+	}
+
+	this->initConstValue(dac_number);
+
+	/* Configure DMA */
+	struct dma_block_config dma_block_config_s = {0};
+	/* Source: waveform table */
+	dma_block_config_s.source_address   = (uint32_t)table;
+	/* Destination: DAC data register */
+	dma_block_config_s.dest_address     = (uint32_t)(&dac_regs->DHR12R1);
+	/* Table size in bytes */
+	dma_block_config_s.block_size       = sample_count * sizeof(uint16_t);
+	/* Source: increment in memory */
+	dma_block_config_s.source_addr_adj  = DMA_ADDR_ADJ_INCREMENT;
+	/* Destination: no increment in DAC register */
+	dma_block_config_s.dest_addr_adj    = DMA_ADDR_ADJ_NO_CHANGE;
+	/* Circular mode: reload addresses on block completion */
+	dma_block_config_s.source_reload_en = 1;
+	dma_block_config_s.dest_reload_en   = 1;
+
+	struct dma_config dma_config_s = {0};
+	/* Trigger source: DAC */
+	dma_config_s.dma_slot            = dma_slot;
+	/* From memory to peripheral */
+	dma_config_s.channel_direction   = MEMORY_TO_PERIPHERAL;
+	/* Source and destination: 2 bytes (uint16_t) */
+	dma_config_s.source_data_size    = 2;
+	dma_config_s.dest_data_size      = 2;
+	/* No burst */
+	dma_config_s.source_burst_length = 1;
+	dma_config_s.dest_burst_length   = 1;
+	/* 1 block */
+	dma_config_s.block_count         = 1;
+	/* Block config as defined above */
+	dma_config_s.head_block          = &dma_block_config_s;
+	/* DMA interrupt callback */
+	dma_config_s.dma_callback        = _dac_waveform_dma_callback;
+
+	if (dma_config(dma1, DAC_WAVEFORM_DMA_CHANNEL, &dma_config_s) != 0)
+	{
+		return -1;
+	}
+
+	/* No CPU involvement after setup */
+	LL_DMA_DisableIT_HT(DMA1, DAC_WAVEFORM_DMA_CHANNEL - 1);
+	LL_DMA_DisableIT_TC(DMA1, DAC_WAVEFORM_DMA_CHANNEL - 1);
+
+	dma_start(dma1, DAC_WAVEFORM_DMA_CHANNEL);
+
+	/* Trigger selection is only possible while the channel is disabled */
+	LL_DAC_Disable(dac_regs, LL_DAC_CHANNEL_1);
+	LL_DAC_SetTriggerSource(dac_regs, LL_DAC_CHANNEL_1, trigger_source);
+	LL_DAC_EnableTrigger(dac_regs, LL_DAC_CHANNEL_1);
+	LL_DAC_EnableDMAReq(dac_regs, LL_DAC_CHANNEL_1);
+	LL_DAC_Enable(dac_regs, LL_DAC_CHANNEL_1);
+
+	k_busy_wait(LL_DAC_DELAY_STARTUP_VOLTAGE_SETTLING_US);
+
+	waveform_dac = dac_regs;
+
+	return 0;
+}
+
+int8_t DacHAL::initWaveform(uint8_t dac_number,
+							const uint16_t* table,
+							uint16_t sample_count,
+							uint32_t sample_frequency)
+{
+	if ( (sample_frequency == 0) || (waveform_dac != nullptr) )
+	{
+		return -1;
+	}
+
+	uint32_t timer_clock = _dac_waveform_timer_clock();
+
+	if (timer_clock < sample_frequency)
+	{
+		return -1;
+	}
+
+	/* Timer update event triggers one DAC conversion per sample */
+	uint32_t ticks = timer_clock / sample_frequency;
+	uint32_t prescaler = ticks / 65536;
+	uint32_t auto_reload = ticks / (prescaler + 1) - 1;
+
+	LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM15);
+	LL_TIM_DisableCounter(DAC_WAVEFORM_TIMER);
+	LL_TIM_SetPrescaler(DAC_WAVEFORM_TIMER, prescaler);
+	LL_TIM_SetAutoReload(DAC_WAVEFORM_TIMER, auto_reload);
+
+	LL_TIM_SetTriggerOutput(DAC_WAVEFORM_TIMER, LL_TIM_TRGO_UPDATE);
+
+	/**
+	 * Prescaler is buffered until the next update event: force one
+	 * so that the first samples are already paced at the right rate.
+	 * The DAC trigger is not enabled yet, so no sample is output.
+	 */
+	LL_TIM_GenerateEvent_UPDATE(DAC_WAVEFORM_TIMER);
+	LL_TIM_ClearFlag_UPDATE(DAC_WAVEFORM_TIMER);
+
+	int8_t err = this->startWaveform(dac_number,
+									 table,
+									 sample_count,
+									 LL_DAC_TRIG_EXT_TIM15_TRGO);
+	if (err == 0)
+	{
+		LL_TIM_EnableCounter(DAC_WAVEFORM_TIMER);
+		waveform_timer_triggered = true;
+	}
+
+	return err;
+}
+
+int8_t DacHAL::initWaveformOnPwm(uint8_t dac_number,
+								 const uint16_t* table,
+								 uint16_t sample_count,
+								 hrtim_tu_t tu_src)
+{
+	hrtim_tu_number_t tu_number;
+	uint32_t trigger_source;
+
+	switch (tu_src)
+	{
+		case TIMA:
+			tu_number = PWMA;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG1;
+			break;
+		case TIMB:
+			tu_number = PWMB;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG2;
+			break;
+		case TIMC:
+			tu_number = PWMC;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG3;
+			break;
+		case TIMD:
+			tu_number = PWMD;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG4;
+			break;
+		case TIME:
+			tu_number = PWME;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG5;
+			break;
+		case TIMF:
+			tu_number = PWMF;
+			trigger_source = LL_DAC_TRIG_EXT_HRTIM_RST_TRG6;
+			break;
+		default:
+			return -1;
+	}
+
+	/* Timing unit counter reset drives the DAC reset trigger */
+	DualDAC_init(tu_number);
+
+	return this->startWaveform(dac_number, table, sample_count, trigger_source);
+}
+
+void DacHAL::stopWaveform()
+{
+	if (waveform_dac == nullptr)
+	{
+		return;
+	}
+
+	DAC_TypeDef* dac_regs = waveform_dac;
+
+	LL_DAC_DisableDMAReq(dac_regs, LL_DAC_CHANNEL_1);
+	LL_DAC_DisableTrigger(dac_regs, LL_DAC_CHANNEL_1);
+	dma_stop(dma1, DAC_WAVEFORM_DMA_CHANNEL);
+
+	/* TIM15 is not started when the waveform is paced by the HRTIM */
+	if (waveform_timer_triggered == true)
+	{
+		LL_TIM_DisableCounter(DAC_WAVEFORM_TIMER);
+		waveform_timer_triggered = false;
+	}
+
+	waveform_dac = nullptr;
+}
@@ -37,6 +37,15 @@
 /* OwnTech Modules */
 #include "hrtim_enum.h"
 
+/** @brief Number of internal signals that can be probed on DAC outputs */
+#define DAC_PROBE_COUNT 2
+
+/** @brief Voltage reference of the DACs, shared with the ADCs, in V */
+#define DAC_VREF 2.048f
+
+/** @brief Number of codes of the 12-bit DACs */
+#define DAC_RESOLUTION 4096.0f
+
 
 class DacHAL
 {
@@ -97,6 +106,108 @@ public:
 	 * @param low_voltage  The valley (starting) voltage of the ramp.
 	 */
 	void currentModeInit(uint8_t dac_number, hrtim_tu_t tu_src);
+
+	/**
+	 * @brief Map an internal signal to a DAC output to observe it on a scope.
+	 *
+	 * The DAC is set in constant output mode on its external pin, and
+	 * scale/offset are converted once to DAC codes so that `probe()` only
+	 * costs a multiply-add and a register store.
+	 *
+	 * @param probe_number Probe index: `0` to `DAC_PROBE_COUNT - 1`
+	 * @param dac_number   DAC with an external output: `1` or `2`
+	 * @param scale        Output voltage per unit of the signal (V/unit)
+	 * @param offset       Output voltage when the signal is zero (V)
+	 *
+	 * @return `0` if the probe was configured, `-1` if a parameter
+	 *         is invalid or the DAC is not ready.
+	 *
+	 * @warning DAC 1 is used for slope compensation in current mode.
+	 */
+	int8_t initProbe(uint8_t probe_number,
+					 uint8_t dac_number,
+					 float32_t scale,
+					 float32_t offset);
+
+	/**
+	 * @brief Output the value of a probed signal.
+	 *
+	 * Output saturates between 0 and the DAC reference voltage.
+	 * Meant to be called once per tick from the critical task.
+	 *
+	 * @param probe_number Probe index, configured with `initProbe()`
+	 * @param value        Current value of the signal
+	 */
+	void probe(uint8_t probe_number, float32_t value);
+
+	/**
+	 * @brief Generate an arbitrary waveform on a DAC output, timer triggered.
+	 *
+	 * The table is copied to the DAC by a circular DMA transfer, one
+	 * sample on each `TIM15` update event, with no CPU involvement after
+	 * setup. Output can be looped back to an ADC input for testing.
+	 *
+	 * @param dac_number       DAC with an external output: `1` or `2`
+	 * @param table            Samples (0–4095). Must remain valid while
+	 *                         the waveform is generated.
+	 * @param sample_count     Number of samples in the table
+	 * @param sample_frequency Sample rate in Hz
+	 *
+	 * @return `0` if generation started, `-1` if a parameter is invalid,
+	 *         the DAC is not ready or a waveform is already generated.
+	 *
+	 * @note Only one waveform can be generated at a time (DMA 1 channel 8).
+	 */
+	int8_t initWaveform(uint8_t dac_number,
+						const uint16_t* table,
+						uint16_t sample_count,
+						uint32_t sample_frequency);
+
+	/**
+	 * @brief Generate an arbitrary waveform on a DAC output, one sample
+	 *        per PWM period of an HRTIM timing unit.
+	 *
+	 * Same as `initWaveform()`, but the DAC is triggered by the counter
+	 * reset of `tu_src`, so the waveform is synchronous with its PWM.
+	 *
+	 * @param dac_number   DAC with an external output: `1` or `2`
+	 * @param table        Samples (0–4095)
+	 * @param sample_count Number of samples in the table
+	 * @param tu_src       HRTIM timing unit: `TIMA` to `TIMF`
+	 *
+	 * @return `0` if generation started, `-1` otherwise.
+	 *
+	 * @warning The timing unit must be initialized before calling this function.
+	 */
+	int8_t initWaveformOnPwm(uint8_t dac_number,
+							 const uint16_t* table,
+							 uint16_t sample_count,
+							 hrtim_tu_t tu_src);
+
+	/**
+	 * @brief Stop the waveform generation.
+	 *
+	 * The DAC keeps its last output value.
+	 */
+	void stopWaveform();
+
+private:
+	/* Start circular DMA from a table to a DAC, triggered by trigger_source */
+	int8_t startWaveform(uint8_t dac_number,
+						 const uint16_t* table,
+						 uint16_t sample_count,
+						 uint32_t trigger_source);
+
+	/* DAC channel generating the waveform, nullptr if none */
+	static DAC_TypeDef* waveform_dac;
+	/* True when the waveform is paced by TIM15, false when by the HRTIM */
+	static bool waveform_timer_triggered;
+
+	/* DAC data register of each probe, nullptr if not configured */
+	static volatile uint32_t* probe_register[DAC_PROBE_COUNT];
+	/* Probe scale and offset, in DAC codes */
+	static float32_t probe_gain[DAC_PROBE_COUNT];
+	static float32_t probe_offset[DAC_PROBE_COUNT];
 };
 
 
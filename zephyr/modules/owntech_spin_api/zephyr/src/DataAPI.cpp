@@ -49,11 +49,24 @@ uint8_t DataAPI::channels_ranks[ADC_COUNT][CHANNELS_PER_ADC] = {0};
 uint8_t DataAPI::current_rank[ADC_COUNT] = {0};
 DispatchMethod_t DataAPI::dispatch_method = DispatchMethod_t::on_dma_interrupt;
 uint32_t DataAPI::repetition_count_between_dispatches = 0;
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+/* Converted values of each enabled channel, in rank order for each ADC */
+static float32_t converted_values_buffer[DATA_STATIC_CHANNELS_TOTAL]
+										[CHANNELS_BUFFERS_SIZE];
+#else
 float32_t*** DataAPI::converted_values_buffer = nullptr;
+#endif
 
 
 adc_t DataAPI::current_adc[PIN_COUNT] = {DEFAULT_ADC};
 
+/**
+ * Channel number resolved when acquisition is enabled on a pin, so that
+ * getLatestValue() does not go through getChannelNumber() on each call.
+ * 0 means acquisition has not been enabled on this pin.
+ */
+uint8_t DataAPI::current_channel[PIN_COUNT] = {0};
+
 /**
  *  Public functions accessible only when using a power shield
  */
@@ -82,6 +95,7 @@ int8_t DataAPI::enableAcquisition(uint8_t pin_num, adc_t adc_num)
 	if (err == 0)
 	{
 		DataAPI::current_adc[pin_num-1] = adc_num;
+		DataAPI::current_channel[pin_num-1] = channel_num;
 	}
 
 	return err;
@@ -136,6 +150,7 @@ int8_t DataAPI::stop()
 
 	adc_stop();
 
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
 	/* Free buffers storage */
 	if (DataAPI::converted_values_buffer != nullptr)
 	{
@@ -155,6 +170,7 @@ int8_t DataAPI::stop()
 		delete DataAPI::converted_values_buffer;
 		DataAPI::converted_values_buffer = nullptr;
 	}
+#endif
 
 	DataAPI::is_started = false;
 
@@ -248,7 +264,8 @@ float32_t DataAPI::getLatestValue(uint8_t pin_num, uint8_t* dataValid)
 		return NO_VALUE;
 	}
 
-	uint8_t channel_num = this->getChannelNumber(adc_num, pin_num);
+	/* Channel was resolved by enableAcquisition(): skip the pin lookup */
+	uint8_t channel_num = DataAPI::current_channel[pin_num-1];
 	if (channel_num == 0)
 	{
 		if (dataValid != nullptr)
@@ -398,6 +415,48 @@ int8_t DataAPI::retrieveConversionParametersFromMemory(uint8_t pin_num)
 																channel_num);
 }
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+
+int8_t DataAPI::enableHardwareFilter(uint8_t pin_num)
+{
+	adc_t adc_num = DataAPI::getCurrentAdcForPin(pin_num);
+	if (adc_num == UNKNOWN_ADC)
+	{
+		return -1;
+	}
+
+	uint8_t channel_rank =
+				DataAPI::getChannelRank(adc_num,
+										DataAPI::current_channel[pin_num-1]);
+	if (channel_rank == 0)
+	{
+		return -1;
+	}
+
+	return data_dispatch_set_hardware_filter(adc_num, channel_rank, true);
+}
+
+void DataAPI::disableHardwareFilter(uint8_t pin_num)
+{
+	adc_t adc_num = DataAPI::getCurrentAdcForPin(pin_num);
+	if (adc_num == UNKNOWN_ADC)
+	{
+		return;
+	}
+
+	uint8_t channel_rank =
+				DataAPI::getChannelRank(adc_num,
+										DataAPI::current_channel[pin_num-1]);
+	if (channel_rank == 0)
+	{
+		return;
+	}
+
+	data_dispatch_set_hardware_filter(adc_num, channel_rank, false);
+}
+
+#endif
+
 void DataAPI::configureDiscontinuousMode(adc_t adc_number,
 										 uint32_t discontinuous_count)
 {
@@ -411,6 +470,30 @@ void DataAPI::configureDiscontinuousMode(adc_t adc_number,
 	adc_configure_discontinuous_mode(adc_number, discontinuous_count);
 }
 
+int8_t DataAPI::configureAveraging(adc_t adc_number, uint8_t samples_count)
+{
+	if ( (adc_number == UNKNOWN_ADC) || (adc_number == DEFAULT_ADC) ||
+		 (samples_count < 1) || (samples_count > 32) ||
+		 (DataAPI::is_started == true) )
+	{
+		return -1;
+	}
+
+	data_dispatch_set_averaging(adc_number, samples_count);
+
+	return 0;
+}
+
+uint32_t DataAPI::getSequenceTimeNs(adc_t adc_number)
+{
+	if ( (adc_number == UNKNOWN_ADC) || (adc_number == DEFAULT_ADC) )
+	{
+		return 0;
+	}
+
+	return adc_get_sequence_time_ns(adc_number);
+}
+
 void DataAPI::configureTriggerSource(adc_t adc_number,
 									 trigger_source_t trigger_source)
 {
@@ -571,6 +654,14 @@ float32_t* DataAPI::getChannelValues(adc_t adc_number,
 
 	/* At least one value to convert: make sure a buffer is available */
 	uint8_t adc_index = (uint8_t)adc_number - 1;
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	/* Values were acquired, so the channel rank fits in static buffers */
+	float32_t* converted_values =
+		converted_values_buffer[data_static_channels_offset(adc_index) +
+								DataAPI::getChannelRank(adc_number,
+														channel_num) - 1];
+#else
 	uint8_t channel_index = channel_num - 1;
 	if (DataAPI::converted_values_buffer == nullptr)
 	{
@@ -596,17 +687,21 @@ float32_t* DataAPI::getChannelValues(adc_t adc_number,
 										new float32_t[CHANNELS_BUFFERS_SIZE];
 	}
 
+	float32_t* converted_values =
+		DataAPI::converted_values_buffer[adc_index][channel_index];
+#endif
+
 	/* Proceed to conversion */
 	for (uint32_t i = 0 ; i < number_of_values_acquired ; i++)
 	{
-		DataAPI::converted_values_buffer[adc_index][channel_index][i] =
+		converted_values[i] =
 					data_conversion_convert_raw_value(adc_number,
 													  channel_num,
 													  raw_values[i]);
 	}
 
 	/* Return converted values buffer */
-	return DataAPI::converted_values_buffer[adc_index][channel_index];
+	return converted_values;
 }
 
 float32_t DataAPI::peekChannel(adc_t adc_num, uint8_t channel_num)
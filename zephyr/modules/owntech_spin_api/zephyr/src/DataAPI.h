@@ -512,6 +512,48 @@ public:
 	 */
 	int8_t retrieveConversionParametersFromMemory(uint8_t pin_number);
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+	/**
+	 * @brief Filter the values of a pin with the FMAC hardware filter.
+	 *
+	 *        Every reading of the pin is filtered at the acquisition
+	 *        rate, so that all functions of this API return filtered
+	 *        values for this pin. Readings are fed to the FMAC by DMA
+	 *        after each dispatch, and filtered values are stored by the
+	 *        FMAC interrupt once the block is done.
+	 *        This interrupt cannot preempt the critical task: in the
+	 *        default task dispatch mode, the values filtered from a
+	 *        dispatch are only available from the next control period,
+	 *        so that the latest value of a filtered pin is always one
+	 *        control period late. In interrupt dispatch mode, it may be
+	 *        one dispatch late.
+	 *        Filter must first be loaded with `fmac_load_fir()` or
+	 *        `fmac_load_iir()`, with a unity DC gain so that conversion
+	 *        parameters still apply.
+	 *
+	 * @note  Up to `FILTERED_CHANNELS_MAX` (4) pins of the same ADC can
+	 *        be filtered, all with the same loaded filter, each keeping
+	 *        its own filter history. Readings of these pins are
+	 *        interleaved, so that the loaded coefficients are spread:
+	 *        see `fmac_start()` for the resulting limits.
+	 *
+	 * @param[in] pin_number SPIN pin number
+	 *
+	 * @return `0` if filter was enabled, `-1` if acquisition is not
+	 *         enabled on this pin, too many pins are filtered or filtered
+	 *         pins are acquired by another ADC.
+	 */
+	int8_t enableHardwareFilter(uint8_t pin_number);
+
+	/**
+	 * @brief Stop filtering the values of a pin with the FMAC
+	 *        hardware filter.
+	 *
+	 * @param[in] pin_number SPIN pin number
+	 */
+	void disableHardwareFilter(uint8_t pin_number);
+#endif
+
 	/**
 	 * @brief Set the discontinuous count for an ADC.
 	 * 
@@ -532,6 +574,45 @@ public:
 	void configureDiscontinuousMode(adc_t adc_number,
 									uint32_t dicontinuous_count);
 
+	/**
+	 * @brief Average consecutive acquisitions of an ADC.
+	 *
+	 *        Each channel of the ADC is acquired `samples_count` times,
+	 *        and the mean of these acquisitions is dispatched as a single
+	 *        value. With an ADC triggered several times per PWM period,
+	 *        this gives one less noisy value per period without adding
+	 *        a filter delay in the control task.
+	 *
+	 *        By default, acquisitions are not averaged.
+	 *
+	 * @note  Must be called before data acquisition is started, as buffers
+	 *        are sized accordingly.
+	 *
+	 * @note  Averaging assumes each trigger converts the whole sequence
+	 *        of the ADC: in discontinuous mode with a count lower than
+	 *        the number of enabled channels, averaged values would mix
+	 *        acquisitions made on different triggers.
+	 *
+	 * @param[in] adc_number Number of the ADC to configure.
+	 * @param[in] samples_count Number of acquisitions averaged into one
+	 *            value, between 1 (no averaging) and 32.
+	 *
+	 * @return `0` on success, `-1` if a parameter is invalid or
+	 *         acquisition is already started.
+	 */
+	int8_t configureAveraging(adc_t adc_number, uint8_t samples_count);
+
+	/**
+	 * @brief Get the time an ADC takes to convert its whole sequence of
+	 *        enabled channels after a single trigger.
+	 *
+	 * @param[in] adc_number Number of the ADC.
+	 *
+	 * @return Sequence conversion time in nanoseconds, 0 if the ADC
+	 *         number is invalid or no channel is enabled.
+	 */
+	uint32_t getSequenceTimeNs(adc_t adc_number);
+
 	/**
 	 * @brief Change the trigger source of an ADC.
 	 * 
@@ -556,6 +637,7 @@ private:
 	 *
 	 * This function configures each ADC with a default software trigger source
 	 * and sets the adcInitialized flag to true.
+	 * Peripherals are only powered on start, for ADCs with enabled channels.
 	 */
 	static void initializeAllAdcs();
 
@@ -726,7 +808,10 @@ private:
 	static DispatchMethod_t dispatch_method;
 	static uint32_t repetition_count_between_dispatches;
 	static adc_t current_adc[PIN_COUNT];
+	static uint8_t current_channel[PIN_COUNT];
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
 	static float32_t*** converted_values_buffer;
+#endif
 
 };
 
@@ -99,6 +99,29 @@ uint8_t GpioHAL::readPin(uint8_t pin)
 	return 0;
 }
 
+fast_pin_t GpioHAL::getFastPin(uint8_t pin)
+{
+	fast_pin_t fast_pin = {nullptr, nullptr, 0};
+
+	gpio_pin_t pin_number = this->getPinNumber(pin);
+	const struct device* port = this->getGpioDevice(pin);
+
+	GPIO_TypeDef* port_regs = nullptr;
+	if      (port == GPIO_A) port_regs = GPIOA;
+	else if (port == GPIO_B) port_regs = GPIOB;
+	else if (port == GPIO_C) port_regs = GPIOC;
+	else if (port == GPIO_D) port_regs = GPIOD;
+
+	if ( (port_regs != nullptr) && (pin_number < 16) )
+	{
+		fast_pin.bsrr = &port_regs->BSRR;
+		fast_pin.odr  = &port_regs->ODR;
+		fast_pin.mask = 1U << pin_number;
+	}
+
+	return fast_pin;
+}
+
 gpio_pin_t GpioHAL::getPinNumber(uint8_t pin)
 {
 	/* Nucleo format */
@@ -29,6 +29,8 @@
 
 #include <zephyr/drivers/gpio.h>
 
+#include <stm32_ll_gpio.h>
+
 
 /**
  *  Public constants
@@ -127,6 +129,17 @@ typedef enum : uint8_t
 	PD3  = PD | P3
 } pin_t;
 
+/**
+ * @brief Precomputed handle to drive an output pin with direct
+ *        register accesses, see `GpioHAL::getFastPin()`.
+ */
+typedef struct
+{
+	volatile uint32_t* bsrr;
+	volatile uint32_t* odr;
+	uint32_t mask;
+} fast_pin_t;
+
 
 /**
  *  Class definition
@@ -225,6 +238,59 @@ public:
 	 */
 	uint8_t readPin(uint8_t pin);
 
+	/**
+	 * @brief Get a fast handle on a pin configured as output.
+	 *
+	 *        Port and pin are resolved once, so that `setFastPin()`,
+	 *        `resetFastPin()` and `toggleFastPin()` are inline register
+	 *        accesses. Meant for timing measurements in the critical task.
+	 *
+	 * @param pin Number of pin. Format allowed: 
+	 * 
+	 * - the Spin pin number from 1 to 58
+	 * 
+	 * - STM32-style pin name from `PA1` to `PA15`, `PB1` to `PB15`, 
+	 * 								`PC1` to `PC15` and `PD1` to `PD3`
+	 *   
+	 * @return Pin handle. Its `bsrr` field is `nullptr` if the pin is
+	 *         unknown.
+	 *
+	 * @warning The handle bypasses the pin polarity flags of Zephyr:
+	 *          set always drives the pin high.
+	 */
+	fast_pin_t getFastPin(uint8_t pin);
+
+	/**
+	 * @brief Set a pin to 1 using its fast handle: a single store.
+	 *
+	 * @param pin Handle obtained from `getFastPin()`
+	 */
+	inline void setFastPin(fast_pin_t pin)
+	{
+		*pin.bsrr = pin.mask;
+	}
+
+	/**
+	 * @brief Reset a pin to 0 using its fast handle: a single store.
+	 *
+	 * @param pin Handle obtained from `getFastPin()`
+	 */
+	inline void resetFastPin(fast_pin_t pin)
+	{
+		*pin.bsrr = pin.mask << 16;
+	}
+
+	/**
+	 * @brief Toggle a pin using its fast handle: a load and a store,
+	 *        without read-modify-write of the output register.
+	 *
+	 * @param pin Handle obtained from `getFastPin()`
+	 */
+	inline void toggleFastPin(fast_pin_t pin)
+	{
+		*pin.bsrr = ((*pin.odr & pin.mask) != 0) ? (pin.mask << 16) : pin.mask;
+	}
+
 private:
 	/**
 	 * @brief Get the GPIO pin number associated with a logical shield pin.
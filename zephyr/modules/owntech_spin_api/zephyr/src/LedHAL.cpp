@@ -27,16 +27,75 @@
 /* Zephyr */
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/clock_control.h>
+#include <zephyr/drivers/clock_control/stm32_clock_control.h>
+
+/* STM32 LL */
+#include <stm32_ll_bus.h>
+#include <stm32_ll_dma.h>
+#include <stm32_ll_gpio.h>
+#include <stm32_ll_tim.h>
 
 /* Current file header */
 #include "LedHAL.h"
 
 
 bool LedHAL::ledInitialized = false;
+bool LedHAL::patternRunning = false;
 
 static struct gpio_dt_spec led_pin_spec =
 							GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
 
+/**
+ * Pattern engine
+ * The LED is on PA5, which is TIM2 channel 1 (AF1). TIM2 counts at 10 kHz
+ * and each update event is a pattern step: it requests DMA 2 channel 3
+ * (channels 1 and 2 are used by USART1) to load the next compare value.
+ * Compare is either 0 (LED off) or above the period (LED on).
+ */
+
+#define LED_PATTERN_DMA         DMA2
+#define LED_PATTERN_DMA_CHANNEL LL_DMA_CHANNEL_3
+
+static const uint32_t LED_PATTERN_TIMER_FREQUENCY = 10000;
+static const uint32_t LED_PATTERN_STEP_TICKS      = 625; /* 62.5 ms */
+static const uint8_t  LED_PATTERN_STEPS           = 32;
+
+static uint32_t led_pattern_steps[LED_PATTERN_STEPS];
+
+static const uint32_t led_patterns[] =
+{
+	0xFFFFFFFF, /* LED_PATTERN_IDLE */
+	0x0F0F0F0F, /* LED_PATTERN_POWER */
+	0x55555555  /* LED_PATTERN_CAPTURE_ARMED */
+};
+
+
+/**
+ * Kernel clock of TIM2: TIM2 is on APB1, and timers run at twice the APB
+ * clock when the APB prescaler is not 1.
+ * Returns 0 if the clock rate is not available.
+ */
+static uint32_t _led_pattern_timer_clock()
+{
+	const struct device* clk = DEVICE_DT_GET(STM32_CLOCK_CONTROL_NODE);
+	struct stm32_pclken pclken =
+	{
+		.bus = STM32_CLOCK_BUS_APB1,
+		.enr = LL_APB1_GRP1_PERIPH_TIM2
+	};
+	uint32_t apb_clock = 0;
+
+	if (clock_control_get_rate(clk,
+							   (clock_control_subsys_t)&pclken,
+							   &apb_clock) != 0)
+	{
+		return 0;
+	}
+
+	return (STM32_APB1_PRESCALER == 1) ? apb_clock : apb_clock * 2;
+}
+
 
 void LedHAL::initialize()
 {
@@ -44,8 +103,127 @@ void LedHAL::initialize()
 	ledInitialized = true;
 }
 
+void LedHAL::startPattern()
+{
+	uint32_t timer_clock = _led_pattern_timer_clock();
+
+	if ( (patternRunning == true) ||
+		 (timer_clock < LED_PATTERN_TIMER_FREQUENCY) )
+	{
+		return;
+	}
+
+	/* Pattern steps are loaded in TIM2 CCR1 at each update event */
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMAMUX1);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+	LL_DMA_DisableChannel(LED_PATTERN_DMA, LED_PATTERN_DMA_CHANNEL);
+	LL_DMA_ConfigTransfer(LED_PATTERN_DMA,
+						  LED_PATTERN_DMA_CHANNEL,
+						  LL_DMA_DIRECTION_MEMORY_TO_PERIPH |
+						  LL_DMA_MODE_CIRCULAR              |
+						  LL_DMA_PERIPH_NOINCREMENT         |
+						  LL_DMA_MEMORY_INCREMENT           |
+						  LL_DMA_PDATAALIGN_WORD            |
+						  LL_DMA_MDATAALIGN_WORD            |
+						  LL_DMA_PRIORITY_LOW);
+	LL_DMA_SetPeriphRequest(LED_PATTERN_DMA,
+							LED_PATTERN_DMA_CHANNEL,
+							LL_DMAMUX_REQ_TIM2_UP);
+	LL_DMA_SetPeriphAddress(LED_PATTERN_DMA,
+							LED_PATTERN_DMA_CHANNEL,
+							(uint32_t)&(TIM2->CCR1));
+	LL_DMA_SetMemoryAddress(LED_PATTERN_DMA,
+							LED_PATTERN_DMA_CHANNEL,
+							(uint32_t)led_pattern_steps);
+	LL_DMA_SetDataLength(LED_PATTERN_DMA,
+						 LED_PATTERN_DMA_CHANNEL,
+						 LED_PATTERN_STEPS);
+	LL_DMA_EnableChannel(LED_PATTERN_DMA, LED_PATTERN_DMA_CHANNEL);
+
+	LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+
+	LL_TIM_DisableCounter(TIM2);
+	LL_TIM_SetPrescaler(TIM2, timer_clock / LED_PATTERN_TIMER_FREQUENCY - 1);
+	LL_TIM_SetAutoReload(TIM2, LED_PATTERN_STEP_TICKS - 1);
+	LL_TIM_OC_SetMode(TIM2, LL_TIM_CHANNEL_CH1, LL_TIM_OCMODE_PWM1);
+	LL_TIM_OC_EnablePreload(TIM2, LL_TIM_CHANNEL_CH1);
+	LL_TIM_CC_EnableChannel(TIM2, LL_TIM_CHANNEL_CH1);
+	LL_TIM_EnableDMAReq_UPDATE(TIM2);
+	LL_TIM_SetCounter(TIM2, 0);
+	LL_TIM_EnableCounter(TIM2);
+
+	/* Pin goes to the timer only once the timer is running */
+	LL_GPIO_SetAFPin_0_7(GPIOA, LL_GPIO_PIN_5, LL_GPIO_AF_1);
+	LL_GPIO_SetPinMode(GPIOA, LL_GPIO_PIN_5, LL_GPIO_MODE_ALTERNATE);
+
+	patternRunning = true;
+}
+
+void LedHAL::stopPattern()
+{
+	if (patternRunning == false)
+	{
+		return;
+	}
+
+	/* Reconfiguring the pin as GPIO takes it back from the timer */
+	initialize();
+
+	LL_TIM_DisableCounter(TIM2);
+	LL_TIM_DisableDMAReq_UPDATE(TIM2);
+	LL_DMA_DisableChannel(LED_PATTERN_DMA, LED_PATTERN_DMA_CHANNEL);
+
+	patternRunning = false;
+}
+
+void LedHAL::setPattern(led_pattern_t pattern)
+{
+	if (pattern > LED_PATTERN_CAPTURE_ARMED)
+	{
+		return;
+	}
+
+	setCustomPattern(led_patterns[pattern]);
+}
+
+void LedHAL::setFaultPattern(uint8_t fault_class)
+{
+	if (fault_class < 1)
+	{
+		fault_class = 1;
+	}
+	else if (fault_class > 6)
+	{
+		fault_class = 6;
+	}
+
+	/* 125 ms flashes every 250 ms, then a pause */
+	uint32_t pattern = 0;
+	for (uint8_t flash = 0 ; flash < fault_class ; flash++)
+	{
+		pattern |= 0x3U << (4 * flash);
+	}
+
+	setCustomPattern(pattern);
+}
+
+void LedHAL::setCustomPattern(uint32_t pattern)
+{
+	/* Steps are updated in place: DMA picks them up on the fly */
+	for (uint8_t step = 0 ; step < LED_PATTERN_STEPS ; step++)
+	{
+		led_pattern_steps[step] = ((pattern >> step) & 0x1) ?
+								  LED_PATTERN_STEP_TICKS : 0;
+	}
+
+	startPattern();
+}
+
 void LedHAL::turnOn()
 {
+	stopPattern();
+
 	if (ledInitialized == false)
 	{
 		initialize();
@@ -56,6 +234,8 @@ void LedHAL::turnOn()
 
 void LedHAL::turnOff()
 {
+	stopPattern();
+
 	if (ledInitialized == false)
 	{
 		initialize();
@@ -66,6 +246,8 @@ void LedHAL::turnOff()
 
 void LedHAL::toggle()
 {
+	stopPattern();
+
 	if (ledInitialized == false)
 	{
 		initialize();
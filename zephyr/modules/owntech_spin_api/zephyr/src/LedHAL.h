@@ -28,6 +28,26 @@
 #ifndef LEDHAL_H_
 #define LEDHAL_H_
 
+#include <stdint.h>
+
+/**
+ *  Enumerations
+ */
+
+/**
+ * @brief Status patterns played by the LED, see `LedHAL::setPattern()`.
+ *
+ * - `LED_PATTERN_IDLE`: steadily on
+ * - `LED_PATTERN_POWER`: blinking at 2 Hz
+ * - `LED_PATTERN_CAPTURE_ARMED`: flickering at 8 Hz
+ */
+typedef enum
+{
+	LED_PATTERN_IDLE,
+	LED_PATTERN_POWER,
+	LED_PATTERN_CAPTURE_ARMED
+} led_pattern_t;
+
 class LedHAL
 {
 public:
@@ -54,6 +74,35 @@ public:
      */
 	void toggle();
 
+    /**
+     * @brief Play a status pattern on the LED.
+     *
+     * Patterns are played by hardware: a timer drives the LED pin and
+     * DMA loads the timer compare value at each step of the pattern.
+     * They cost no CPU time and keep running whatever the software does.
+     * Patterns last 2 seconds and are repeated until another pattern
+     * is set or the LED is driven with turnOn(), turnOff() or toggle().
+     *
+     * @param pattern Pattern to play.
+     */
+	void setPattern(led_pattern_t pattern);
+
+    /**
+     * @brief Play a fault pattern: a number of short flashes followed
+     *        by a pause, repeated every 2 seconds.
+     *
+     * @param fault_class Number of flashes, from 1 to 6.
+     */
+	void setFaultPattern(uint8_t fault_class);
+
+    /**
+     * @brief Play a custom pattern.
+     *
+     * @param pattern 32 steps of 62.5 ms, from bit 0 to bit 31.
+     *                The LED is on during steps whose bit is 1.
+     */
+	void setCustomPattern(uint32_t pattern);
+
 private:
     /**
      * @brief Initialize the LED hardware.
@@ -65,6 +114,17 @@ private:
      */
 	void initialize();
 
+    /**
+     * @brief Give the LED pin to the pattern timer,
+     *        setting up the timer and DMA on first call.
+     */
+	void startPattern();
+
+    /**
+     * @brief Stop the pattern and give the LED pin back to GPIO.
+     */
+	void stopPattern();
+
     /**
      * @brief Tracks whether the LED has been initialized.
      *
@@ -72,6 +132,11 @@ private:
      */
 	static bool ledInitialized;
 
+    /**
+     * @brief Tracks whether the LED is driven by the pattern timer.
+     */
+	static bool patternRunning;
+
 };
 
 
@@ -368,8 +368,8 @@ public:
       * @param[in] adc_edge_trigger  Rollover mode: 
       *            `EdgeTrigger_up`, `EdgeTrigger_down`, `EdgeTrigger_Both`
       *
-      * @warning This function must be called BEFORE initialiazing
-      *          the selected timing unit
+      * @note  Only used in center-aligned modulation. If the timing unit
+      *        is already started, the new mode is applied immediately.
       */
      void setAdcEdgeTrigger(hrtim_tu_number_t pwmX,
                             hrtim_adc_edgetrigger_t adc_edge_trigger);
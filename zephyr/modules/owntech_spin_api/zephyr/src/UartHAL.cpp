@@ -24,12 +24,16 @@
  */
 
 
+
 /* STM 32 LL */
 #include <stm32_ll_lpuart.h>
+#include <stm32_ll_usart.h>
+#include <stm32_ll_dma.h>
+#include <stm32_ll_bus.h>
 
 /* Zephyr */
+#include <zephyr/kernel.h>
 #include <zephyr/drivers/uart.h>
-#include <zephyr/console/console.h>
 
 /* Current file header */
 #include "UartHAL.h"
@@ -38,36 +42,142 @@
  *  USART 1 defines
  */
 
-#define CONFIG_OWNTECH_SERIAL_TX_BUF_SIZE 5
-#define CONFIG_OWNTECH_SERIAL_RX_BUF_SIZE 5
-#define USART1_DEVICE DT_PROP(DT_NODELABEL(usart1), label)
+/**
+ * DMA 1 channels are all used by ADCs, RS485 and DAC,
+ * DMA 2 is driven directly with LL drivers.
+ */
+#define USART1_DMA            DMA2
+#define USART1_DMA_CHANNEL_RX LL_DMA_CHANNEL_1
+#define USART1_DMA_CHANNEL_TX LL_DMA_CHANNEL_2
+
+static const uint16_t RX_BUFFER_SIZE = CONFIG_OWNTECH_UART_API_RX_BUFFER_SIZE;
+static const uint16_t TX_BUFFER_SIZE = CONFIG_OWNTECH_UART_API_TX_BUFFER_SIZE;
 
 static const struct device* uart_dev = DEVICE_DT_GET(DT_NODELABEL(usart1));
-static char buf_req[CONFIG_OWNTECH_SERIAL_RX_BUF_SIZE];
-static bool command_flag = false;
+
+/* Reception ring: written by DMA, read index managed here */
+static uint8_t rx_buffer[CONFIG_OWNTECH_UART_API_RX_BUFFER_SIZE];
+static uint16_t rx_read_index = 0;
+
+/* Transmission ring: written here, read by DMA */
+static uint8_t tx_buffer[CONFIG_OWNTECH_UART_API_TX_BUFFER_SIZE];
+static volatile uint16_t tx_write_index = 0;
+static volatile uint16_t tx_read_index = 0;
+static volatile uint16_t tx_dma_length = 0;
+
+static uart_idle_callback_t idle_callback = NULL;
+
+static bool usart1_initialized = false;
 
 /**
  *  USART 1 private functions
  */
 
-static void _uart_usart1_process_input(const struct device *dev,
-									   void* user_data)
+/**
+ * Index of the next byte the DMA will write in the reception ring.
+ */
+static uint16_t _uart_usart1_rx_write_index()
 {
-	uint8_t c;
+	return RX_BUFFER_SIZE - LL_DMA_GetDataLength(USART1_DMA,
+												 USART1_DMA_CHANNEL_RX);
+}
 
-	if (!uart_irq_update(uart_dev)) {
-		printk("no data \n");
+/**
+ * Start a DMA transfer of the contiguous part of the transmission
+ * ring, if no transfer is ongoing.
+ * Must be called with interrupts locked or from the DMA interrupt.
+ */
+static void _uart_usart1_tx_start()
+{
+	if ( (tx_dma_length != 0) || (tx_read_index == tx_write_index) )
+	{
 		return;
 	}
 
-	while (uart_irq_rx_ready(uart_dev) && command_flag == false) {
-		uart_fifo_read(uart_dev, &c, 1);
-		printk("received %c \n",c);
-		buf_req[0] = c;
-		command_flag = true;
+	if (tx_write_index > tx_read_index)
+	{
+		tx_dma_length = tx_write_index - tx_read_index;
+	}
+	else
+	{
+		tx_dma_length = TX_BUFFER_SIZE - tx_read_index;
+	}
+
+	LL_DMA_DisableChannel(USART1_DMA, USART1_DMA_CHANNEL_TX);
+	LL_DMA_SetMemoryAddress(USART1_DMA,
+							USART1_DMA_CHANNEL_TX,
+							(uint32_t)&tx_buffer[tx_read_index]);
+	LL_DMA_SetDataLength(USART1_DMA, USART1_DMA_CHANNEL_TX, tx_dma_length);
+	LL_DMA_EnableChannel(USART1_DMA, USART1_DMA_CHANNEL_TX);
+}
+
+/**
+ * DMA TX interrupt: release sent bytes and send the next ones.
+ */
+static void _uart_usart1_dma_tx_callback(const void* arg)
+{
+	ARG_UNUSED(arg);
+
+	if (LL_DMA_IsActiveFlag_TC2(USART1_DMA))
+	{
+		LL_DMA_ClearFlag_TC2(USART1_DMA);
+
+		tx_read_index = (tx_read_index + tx_dma_length) % TX_BUFFER_SIZE;
+		tx_dma_length = 0;
+
+		_uart_usart1_tx_start();
+	}
+}
+
+/**
+ * USART interrupt: data is moved by DMA, only idle line is handled.
+ */
+static void _uart_usart1_process_input(const struct device *dev,
+									   void* user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	if (LL_USART_IsActiveFlag_IDLE(USART1))
+	{
+		LL_USART_ClearFlag_IDLE(USART1);
+
+		if (idle_callback != NULL)
+		{
+			idle_callback();
+		}
 	}
 }
 
+/**
+ * Configure one DMA 2 channel for byte transfers with USART1.
+ */
+static void _uart_usart1_dma_init(uint32_t channel,
+								  uint32_t direction,
+								  uint32_t mode,
+								  uint32_t peripheral_address,
+								  uint32_t memory_address,
+								  uint32_t length,
+								  uint32_t request)
+{
+	LL_DMA_InitTypeDef DMA_InitStruct = {0};
+
+	DMA_InitStruct.Direction = direction;
+	DMA_InitStruct.PeriphOrM2MSrcAddress = peripheral_address;
+	DMA_InitStruct.MemoryOrM2MDstAddress = memory_address;
+	DMA_InitStruct.Mode = mode;
+	DMA_InitStruct.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_BYTE;
+	DMA_InitStruct.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_BYTE;
+	DMA_InitStruct.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+	DMA_InitStruct.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+	DMA_InitStruct.PeriphRequest = request;
+	DMA_InitStruct.NbData = length;
+	DMA_InitStruct.Priority = LL_DMA_PRIORITY_LOW;
+
+	LL_DMA_DisableChannel(USART1_DMA, channel);
+	LL_DMA_Init(USART1_DMA, channel, &DMA_InitStruct);
+}
+
 /**
  *  USART 1 public functions
  */
@@ -83,24 +193,69 @@ void UartHAL::usart1Init()
 		.flow_ctrl = UART_CFG_FLOW_CTRL_NONE
 	};
 
-	if (device_is_ready(uart_dev) == true)
+	if (device_is_ready(uart_dev) == false)
 	{
-		uart_configure(uart_dev, &usart1_config);
+		return;
+	}
 
-		uart_irq_callback_user_data_set(uart_dev,
-										_uart_usart1_process_input,
-										NULL);
+	uart_configure(uart_dev, &usart1_config);
 
-		uart_irq_rx_enable(uart_dev);
-	}
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMAMUX1);
+	LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+	rx_read_index  = 0;
+	tx_write_index = 0;
+	tx_read_index  = 0;
+	tx_dma_length  = 0;
+
+	/* Reception: circular, runs forever */
+	_uart_usart1_dma_init(USART1_DMA_CHANNEL_RX,
+						  LL_DMA_DIRECTION_PERIPH_TO_MEMORY,
+						  LL_DMA_MODE_CIRCULAR,
+						  (uint32_t)&(USART1->RDR),
+						  (uint32_t)rx_buffer,
+						  RX_BUFFER_SIZE,
+						  LL_DMAMUX_REQ_USART1_RX);
+	LL_DMA_EnableChannel(USART1_DMA, USART1_DMA_CHANNEL_RX);
+
+	/* Transmission: one transfer per contiguous chunk of the ring */
+	_uart_usart1_dma_init(USART1_DMA_CHANNEL_TX,
+						  LL_DMA_DIRECTION_MEMORY_TO_PERIPH,
+						  LL_DMA_MODE_NORMAL,
+						  (uint32_t)&(USART1->TDR),
+						  (uint32_t)tx_buffer,
+						  0,
+						  LL_DMAMUX_REQ_USART1_TX);
+	LL_DMA_ClearFlag_TC2(USART1_DMA);
+	LL_DMA_EnableIT_TC(USART1_DMA, USART1_DMA_CHANNEL_TX);
+
+	IRQ_CONNECT(DMA2_Channel2_IRQn, 0, _uart_usart1_dma_tx_callback, NULL, 0);
+	irq_enable(DMA2_Channel2_IRQn);
+
+	/* Data goes through DMA, USART interrupt is only used for idle line */
+	LL_USART_EnableDMAReq_RX(USART1);
+	LL_USART_EnableDMAReq_TX(USART1);
+
+	uart_irq_callback_user_data_set(uart_dev,
+									_uart_usart1_process_input,
+									NULL);
+
+	LL_USART_ClearFlag_IDLE(USART1);
+	LL_USART_EnableIT_IDLE(USART1);
+
+	usart1_initialized = true;
 }
 
 char UartHAL::usart1ReadChar()
 {
-	if (command_flag){
-		command_flag = false;
-		return buf_req[0];
-	} else {
+	uint8_t c;
+
+	if (usart1Read(&c, 1) == 1)
+	{
+		return (char)c;
+	}
+	else
+	{
 		/* returns an x to signal there is no command waiting to be treated */
 		return 'x';
 	}
@@ -108,10 +263,89 @@ char UartHAL::usart1ReadChar()
 
 void UartHAL::usart1WriteChar(char data)
 {
-	if (device_is_ready(uart_dev) == true)
+	usart1Write((const uint8_t*)&data, 1);
+}
+
+uint16_t UartHAL::usart1Available()
+{
+	if (usart1_initialized == false)
+	{
+		return 0;
+	}
+
+	uint16_t write_index = _uart_usart1_rx_write_index();
+
+	if (write_index >= rx_read_index)
+	{
+		return write_index - rx_read_index;
+	}
+	else
+	{
+		return RX_BUFFER_SIZE - rx_read_index + write_index;
+	}
+}
+
+uint16_t UartHAL::usart1Read(uint8_t* data, uint16_t size)
+{
+	uint16_t count = usart1Available();
+
+	if (count > size)
+	{
+		count = size;
+	}
+
+	for (uint16_t i = 0 ; i < count ; i++)
+	{
+		data[i] = rx_buffer[rx_read_index];
+
+		rx_read_index++;
+		if (rx_read_index == RX_BUFFER_SIZE)
+		{
+			rx_read_index = 0;
+		}
+	}
+
+	return count;
+}
+
+uint16_t UartHAL::usart1Write(const uint8_t* data, uint16_t size)
+{
+	if (usart1_initialized == false)
 	{
-		uart_poll_out(uart_dev,data);
+		return 0;
 	}
+
+	uint16_t count = 0;
+	uint16_t write_index = tx_write_index;
+
+	while (count < size)
+	{
+		uint16_t next_index = (write_index + 1) % TX_BUFFER_SIZE;
+
+		/* One slot is kept empty to tell full from empty */
+		if (next_index == tx_read_index)
+		{
+			break;
+		}
+
+		tx_buffer[write_index] = data[count];
+		write_index = next_index;
+		count++;
+	}
+
+	unsigned int key = irq_lock();
+
+	tx_write_index = write_index;
+	_uart_usart1_tx_start();
+
+	irq_unlock(key);
+
+	return count;
+}
+
+void UartHAL::usart1SetIdleCallback(uart_idle_callback_t callback)
+{
+	idle_callback = callback;
 }
 
 void UartHAL::usart1SwapRxTx()
@@ -26,10 +26,22 @@
 #ifndef UARTHAL_H_
 #define UARTHAL_H_
 
+#include <stdint.h>
+
+/**
+ *  Type definitions
+ */
+
+/** @brief Function called from interrupt when the RX line becomes idle */
+typedef void (*uart_idle_callback_t)();
+
 /**
  * @brief  Handles USART1 for the SPIN board
  *
- * @note   Use this element to initialize and send messages via USART1
+ * @note   Use this element to initialize and send messages via USART1.
+ *         Reception and transmission are done by DMA through ring buffers,
+ *         whose sizes are set by `CONFIG_OWNTECH_UART_API_RX_BUFFER_SIZE`
+ *         and `CONFIG_OWNTECH_UART_API_TX_BUFFER_SIZE`.
  */
 class UartHAL
 {
@@ -53,10 +65,50 @@ public:
 	/**
 	 * @brief This function transmits a single character through the USART1
 	 *
-	 * @param data single char to be sent out
+	 * @param data single char to be sent out. It is dropped if the
+	 *             transmission buffer is full.
 	 */
 	void usart1WriteChar(char data);
 
+	/**
+	 * @brief Get the number of received bytes waiting to be read.
+	 *
+	 * @return Number of bytes that can be read with `usart1Read()`
+	 */
+	uint16_t usart1Available();
+
+	/**
+	 * @brief Read received bytes from the reception buffer.
+	 *        This function does not block.
+	 *
+	 * @param data Buffer to copy received bytes to
+	 * @param size Maximum number of bytes to read
+	 *
+	 * @return Number of bytes actually read, `0` if nothing was received
+	 */
+	uint16_t usart1Read(uint8_t* data, uint16_t size);
+
+	/**
+	 * @brief Queue bytes for transmission. Transmission is started
+	 *        immediately by DMA and this function does not block.
+	 *
+	 * @param data Bytes to send
+	 * @param size Number of bytes to send
+	 *
+	 * @return Number of bytes actually queued, lower than `size`
+	 *         if the transmission buffer is full.
+	 */
+	uint16_t usart1Write(const uint8_t* data, uint16_t size);
+
+	/**
+	 * @brief Set a function to be called when the RX line becomes idle
+	 *        after a reception, i.e. at the end of a frame.
+	 *
+	 * @param callback Function called from interrupt context,
+	 *                 `NULL` to disable.
+	 */
+	void usart1SetIdleCallback(uart_idle_callback_t callback);
+
 	/**
 	 * @brief This function swaps the USART RX and TX pins. It should be called
 	 * 		  in conjunction with a board version setup.
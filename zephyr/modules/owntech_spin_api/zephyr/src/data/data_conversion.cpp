@@ -46,6 +46,14 @@ static const uint8_t max_parameters_count = 2;
 static conversion_type_t conversion_types[ADC_COUNT][CHANNELS_PER_ADC];
 static float32_t* conversion_parameters[ADC_COUNT][CHANNELS_PER_ADC];
 
+/* Increased at each parameters change */
+static volatile uint32_t parameters_version = 0;
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+/* Room for the largest parameters set (therm conversion) for each channel */
+static float32_t conversion_parameters_storage[ADC_COUNT][CHANNELS_PER_ADC][4];
+#endif
+
 /* voltage reference from ADC */
 #define VREF 2.048f
 /* ADC resolution */
@@ -81,6 +89,66 @@ static uint8_t _data_conversion_get_parameters_count(conversion_type_t type)
 	return parameters_count;
 }
 
+/**
+ * Set the conversion type and parameters of a channel.
+ *
+ * Conversion may run in an interrupt at any time: the type and
+ * parameters are published together with interrupts masked.
+ * Parameters are updated in place when the type does not change,
+ * and new memory only replaces the previous one once published.
+ *
+ * Zero-latency interrupts, such as the critical task on TIM6, are not
+ * masked: they may convert a value with partly updated parameters.
+ */
+static void _data_conversion_set_parameters(uint8_t adc_index,
+											uint8_t channel_index,
+											conversion_type_t type,
+											const float32_t* parameters)
+{
+	uint8_t parameters_count = _data_conversion_get_parameters_count(type);
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	float32_t* channel_parameters =
+					conversion_parameters_storage[adc_index][channel_index];
+#else
+	float32_t* channel_parameters =
+					conversion_parameters[adc_index][channel_index];
+	float32_t* previous_parameters = nullptr;
+
+	if ( (channel_parameters == nullptr) ||
+		 (conversion_types[adc_index][channel_index] != type) )
+	{
+		previous_parameters = channel_parameters;
+		channel_parameters  =
+			(float32_t*)k_malloc(parameters_count*sizeof(float32_t));
+		if (channel_parameters == nullptr)
+		{
+			return;
+		}
+	}
+#endif
+
+	unsigned int key = irq_lock();
+
+	for (uint8_t i = 0 ; i < parameters_count ; i++)
+	{
+		channel_parameters[i] = parameters[i];
+	}
+
+	conversion_parameters[adc_index][channel_index] = channel_parameters;
+	conversion_types[adc_index][channel_index]      = type;
+	parameters_version++;
+
+	irq_unlock(key);
+
+#ifndef CONFIG_OWNTECH_STATIC_ALLOCATION
+	if (previous_parameters != nullptr)
+	{
+		k_free(previous_parameters);
+	}
+#endif
+}
+
 /* Public functions */
 
 void data_conversion_init()
@@ -94,30 +162,30 @@ void data_conversion_init()
 		{
 			if (conversion_parameters[adc_index][channel_index] == nullptr)
 			{
-				uint8_t param_count =
-					_data_conversion_get_parameters_count(
-						conversion_types[adc_index][channel_index]
-					);
-
-				conversion_parameters[adc_index][channel_index] =
-					(float32_t*)k_malloc(param_count*sizeof(float32_t));
-
 				switch(conversion_types[adc_index][channel_index])
 				{
 					case conversion_linear:
+					{
 						/* For linear conversion, set default gain to 1
 						 * and default offset to 0 */
-						conversion_parameters[adc_index][channel_index][0]= 1;
-						conversion_parameters[adc_index][channel_index][1]= 0;
+						const float32_t parameters[] = {1, 0};
+						_data_conversion_set_parameters(adc_index,
+														channel_index,
+														conversion_linear,
+														parameters);
 						break;
+					}
 					case conversion_therm:
+					{
 						/* For therm conversion, set all parameters to 1
 						 * by default */
-						conversion_parameters[adc_index][channel_index][0]= 1;
-						conversion_parameters[adc_index][channel_index][1]= 1;
-						conversion_parameters[adc_index][channel_index][2]= 1;
-						conversion_parameters[adc_index][channel_index][3]= 1;
+						const float32_t parameters[] = {1, 1, 1, 1};
+						_data_conversion_set_parameters(adc_index,
+														channel_index,
+														conversion_therm,
+														parameters);
 						break;
+					}
 					case no_channel_error:
 						break;
 				}
@@ -189,17 +257,12 @@ void data_conversion_set_conversion_parameters_linear(
 	uint8_t adc_index     = adc_num - 1;
 	uint8_t channel_index = channel_num - 1;
 
-	conversion_types[adc_index][channel_index] = conversion_linear;
-	if (conversion_parameters[adc_index][channel_index] != nullptr)
-	{
-		k_free(conversion_parameters[adc_index][channel_index]);
-	}
+	const float32_t parameters[] = {gain, offset};
 
-	conversion_parameters[adc_index][channel_index] =
-							(float32_t*)k_malloc(2*sizeof(float32_t));
-
-	conversion_parameters[adc_index][channel_index][0] = gain;
-	conversion_parameters[adc_index][channel_index][1] = offset;
+	_data_conversion_set_parameters(adc_index,
+									channel_index,
+									conversion_linear,
+									parameters);
 }
 
 void data_conversion_set_conversion_parameters_therm(
@@ -213,19 +276,17 @@ void data_conversion_set_conversion_parameters_therm(
 	uint8_t adc_index     = adc_num - 1;
 	uint8_t channel_index = channel_num - 1;
 
-	conversion_types[adc_index][channel_index] = conversion_therm;
-	if (conversion_parameters[adc_index][channel_index] != nullptr)
-	{
-		k_free(conversion_parameters[adc_index][channel_index]);
-	}
+	const float32_t parameters[] = {r0, b, rdiv, t0};
 
-	conversion_parameters[adc_index][channel_index] =
-									(float32_t*)k_malloc(4*sizeof(float32_t));
+	_data_conversion_set_parameters(adc_index,
+									channel_index,
+									conversion_therm,
+									parameters);
+}
 
-	conversion_parameters[adc_index][channel_index][0] = r0;
-	conversion_parameters[adc_index][channel_index][1] = b;
-	conversion_parameters[adc_index][channel_index][2] = rdiv;
-	conversion_parameters[adc_index][channel_index][3] = t0;
+uint32_t data_conversion_get_parameters_version()
+{
+	return parameters_version;
 }
 
 conversion_type_t data_conversion_get_conversion_type(
@@ -294,8 +355,7 @@ int8_t data_conversion_store_channel_parameters_in_nvs(uint8_t adc_num,
 					conversion_types[adc_index][channel_index]
 				);
 
-	uint8_t* buffer =
-			(uint8_t*)k_malloc(1 + 23 + 1 + 1 + 1 + 4*parameters_count);
+	uint8_t buffer[1 + 23 + 1 + 1 + 1 + 4*4];
 
 	snprintk((char*)(&buffer[1]), 23, "Spin_ADC_%u_Channel_%u",
 			 adc_num,
@@ -321,8 +381,6 @@ int8_t data_conversion_store_channel_parameters_in_nvs(uint8_t adc_num,
 				1 + string_len + 1 + 1 + 1 + 4*parameters_count
 			);
 
-	k_free(buffer);
-
 	if (ns < 0)
 	{
 		return -1;
@@ -353,8 +411,8 @@ int8_t data_conversion_retrieve_channel_parameters_from_nvs(uint8_t adc_num,
 	uint16_t channel_ID =
 				ADC_CALIBRATION | (adc_num&0x0F) << 4 | (channel_num&0x0F);
 
-	int buffer_size = 1 + 23 + 1 + 1 + 1 + 4*max_parameters_count;
-	uint8_t* buffer = (uint8_t*)k_malloc(buffer_size);
+	uint8_t buffer[1 + 23 + 1 + 1 + 1 + 4*max_parameters_count];
+	int buffer_size = sizeof(buffer);
 
 	int read_size = nvs_storage_retrieve_data(channel_ID, buffer, buffer_size);
 
@@ -380,20 +438,15 @@ int8_t data_conversion_retrieve_channel_parameters_from_nvs(uint8_t adc_num,
 			uint8_t parameters_count =
 					_data_conversion_get_parameters_count(conversion_type);
 
-			conversion_types[adc_index][channel_index] = conversion_type;
+			float32_t parameters[4];
+			memcpy(parameters,
+				   &buffer[string_len + 4],
+				   4*parameters_count);
 
-			if (conversion_parameters[adc_index][channel_index] != nullptr)
-			{
-				k_free(conversion_parameters[adc_index][channel_index]);
-			}
-			conversion_parameters[adc_index][channel_index] =
-				(float32_t*)k_malloc(parameters_count*sizeof(float32_t));
-
-			for (int i = 0 ; i < parameters_count ; i++)
-			{
-				conversion_parameters[adc_index][channel_index][i] =
-								*((float32_t*)&buffer[string_len + 4 + 4*i]);
-			}
+			_data_conversion_set_parameters(adc_index,
+											channel_index,
+											conversion_type,
+											parameters);
 		}
 	}
 	else
@@ -401,6 +454,5 @@ int8_t data_conversion_retrieve_channel_parameters_from_nvs(uint8_t adc_num,
 		ret = -4;
 	}
 
-	k_free(buffer);
 	return ret;
 }
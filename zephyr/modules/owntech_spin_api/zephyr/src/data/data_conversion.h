@@ -98,6 +98,17 @@ void data_conversion_set_conversion_parameters_therm(uint8_t adc_num,
 													 float32_t rdiv,
 													 float32_t t0);
 
+/**
+ * @brief Get a counter that increases each time the conversion
+ *        parameters of any channel are changed.
+ *
+ * Lets callers keep values derived from conversion parameters,
+ * and refresh them only when parameters have changed.
+ *
+ * @return Current version of the conversion parameters.
+ */
+uint32_t data_conversion_get_parameters_version();
+
 /**
  * @brief Get the conversion type for a given channel
  *
@@ -27,6 +27,7 @@
 /* Stdlib */
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 /* Zephyr */
 #include <zephyr/kernel.h>
@@ -38,6 +39,10 @@
 /* Current module header */
 #include "dma.h"
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+#include "fmac.h"
+#endif
+
 /* Current file header */
 #include "data_dispatch.h"
 
@@ -76,6 +81,16 @@ static uint8_t** current_buffer = nullptr;
  */
 static uint16_t** peek_memory = nullptr;
 
+/**
+ * Averaging: for each ADC, number of consecutive readings of
+ * a channel averaged into a single value (0 or 1 for none).
+ * averaging_sums[x][y] and averaging_counts[x][y] hold the
+ * readings of ADC x+1 Channel y accumulated so far.
+ */
+static uint8_t    averaging_samples[ADC_COUNT] = {0};
+static uint32_t** averaging_sums               = nullptr;
+static uint8_t**  averaging_counts             = nullptr;
+
 /**
  * DMA buffers: data from the ADC 1/2 are stored in these
  * buffers until dispatch is done (ADC 3/4 won't use DMA).
@@ -92,10 +107,108 @@ static size_t    dma_buffer_sizes[ADC_COUNT]      = {0};
 /* Dispatch method */
 static dispatch_t dispatch_type;
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+
+/**
+ * Filtered channels all belong to one ADC. Their readings are
+ * interleaved in rank order into a single stream, which runs through
+ * the FMAC without interruption. Dispatch stores readings in one of
+ * the stream buffers while the other one is being filtered, filtered
+ * values being then stored in the channel buffers.
+ */
+static const uint16_t FILTER_STREAM_SIZE =
+						FILTERED_CHANNELS_MAX * CHANNELS_BUFFERS_SIZE;
+
+/* Filtered ADC, and for each ADC, bit y is set if Channel y is filtered */
+static uint8_t  filter_adc_index = 0;
+static uint32_t filtered_channels_mask[ADC_COUNT] = {0};
+
+/* Channel index of each position in the stream, in rank order */
+static uint8_t filter_slots[FILTERED_CHANNELS_MAX];
+static uint8_t filter_slots_count = 0;
+
+/* Position in the stream of the next staged reading */
+static uint8_t filter_next_slot = 0;
+
+static uint8_t  filter_filling = 0;
+static uint16_t filter_stream_count[2]      = {0};
+static uint8_t  filter_stream_first_slot[2] = {0};
+static int16_t  filter_stream[2][FILTER_STREAM_SIZE];
+static int16_t  filter_output[FILTER_STREAM_SIZE];
+
+/* A stream buffer is being filtered */
+static volatile bool filter_busy = false;
+
+#endif
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+
+/* Largest DMA buffer of an ADC with the given channel count */
+static constexpr size_t _data_dispatch_static_dma_size(uint8_t channels)
+{
+	return (CONFIG_OWNTECH_STATIC_ALLOCATION_DMA_BUFFER_SIZE > 2 * channels) ?
+			CONFIG_OWNTECH_STATIC_ALLOCATION_DMA_BUFFER_SIZE : 2 * channels;
+}
+
+/**
+ * Memory used by an ADC with the given channel count.
+ * Must match allocations done in data_dispatch_init().
+ */
+static constexpr size_t _data_dispatch_static_adc_size(uint8_t channels)
+{
+	return ROUND_UP(_data_dispatch_static_dma_size(channels) * sizeof(uint16_t), 4) +
+		   ROUND_UP(channels * sizeof(uint16_t**), 4) +
+		   ROUND_UP(channels * sizeof(uint32_t),   4) +
+		   ROUND_UP(channels * sizeof(uint8_t),    4) +
+		   ROUND_UP(channels * sizeof(uint16_t),   4) +
+		   ROUND_UP(channels * sizeof(uint32_t),   4) +
+		   ROUND_UP(channels * sizeof(uint8_t),    4) +
+		   channels * (ROUND_UP(2 * sizeof(uint16_t*), 4) +
+					   2 * ROUND_UP(CHANNELS_BUFFERS_SIZE * sizeof(uint16_t), 4));
+}
+
+static const size_t DISPATCH_POOL_SIZE =
+	ROUND_UP(ADC_COUNT * sizeof(uint8_t), 4) +
+	6 * ROUND_UP(ADC_COUNT * sizeof(void*), 4) +
+	_data_dispatch_static_adc_size(DATA_STATIC_CHANNELS_COUNT(adc1)) +
+	_data_dispatch_static_adc_size(DATA_STATIC_CHANNELS_COUNT(adc2)) +
+	_data_dispatch_static_adc_size(DATA_STATIC_CHANNELS_COUNT(adc3)) +
+	_data_dispatch_static_adc_size(DATA_STATIC_CHANNELS_COUNT(adc4)) +
+	_data_dispatch_static_adc_size(DATA_STATIC_CHANNELS_COUNT(adc5));
+
+/* Memory holding all dispatch buffers, handed out by _data_dispatch_alloc() */
+static uint8_t __aligned(4) dispatch_pool[DISPATCH_POOL_SIZE];
+static size_t dispatch_pool_used = 0;
+
+#endif /* CONFIG_OWNTECH_STATIC_ALLOCATION */
+
 /**
  * Private Functions
  */
 
+/**
+ * Get zeroed memory for the dispatch buffers,
+ * from the static pool in static allocation mode,
+ * from the heap otherwise.
+ */
+static void* _data_dispatch_alloc(size_t size)
+{
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	size = ROUND_UP(size, 4);
+	if (dispatch_pool_used + size > DISPATCH_POOL_SIZE)
+		return nullptr;
+
+	void* memory = &dispatch_pool[dispatch_pool_used];
+	dispatch_pool_used += size;
+
+	memset(memory, 0, size);
+
+	return memory;
+#else
+	return k_calloc(1, size);
+#endif
+}
+
 __STATIC_INLINE uint16_t* _data_dispatch_get_buffer(uint8_t adc_index,
 													uint8_t channel_index)
 {
@@ -128,6 +241,115 @@ __STATIC_INLINE void _data_dispatch_swap_buffers(uint8_t adc_index,
 	buffers_data_count[adc_index][channel_index] = 0;
 }
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+
+/**
+ * ADC values are 12-bit unsigned: they are shifted to positive q1.15
+ * values for the FMAC, then shifted back to the ADC scale.
+ *
+ * Readings must enter the stream strictly in slot order: a reading that
+ * is not the expected one, e.g. after a reading was dropped, is dropped
+ * too until the expected slot comes again.
+ */
+__STATIC_INLINE void _data_dispatch_filter_stage(uint8_t channel_index,
+												 uint16_t raw_value)
+{
+	if (filter_slots[filter_next_slot] != channel_index)
+		return;
+
+	uint16_t* count = &filter_stream_count[filter_filling];
+	if ( (*count) >= FILTER_STREAM_SIZE)
+		return;
+
+	filter_stream[filter_filling][*count] = (int16_t)(raw_value << 3);
+	(*count)++;
+
+	filter_next_slot++;
+	if (filter_next_slot >= filter_slots_count)
+	{
+		filter_next_slot = 0;
+	}
+}
+
+/**
+ * FMAC interrupt: store filtered values in the channel buffers.
+ */
+static void _data_dispatch_filter_done(int8_t status)
+{
+	uint8_t filtered = filter_filling ^ 1;
+
+	if (status == 0)
+	{
+		uint8_t slot = filter_stream_first_slot[filtered];
+
+		for (uint16_t i = 0 ; i < filter_stream_count[filtered] ; i++)
+		{
+			uint8_t channel_index = filter_slots[slot];
+
+			uint16_t* active_buffer =
+						_data_dispatch_get_buffer(filter_adc_index,
+												  channel_index);
+			uint32_t  current_count =
+						_data_dispatch_get_count(filter_adc_index,
+												 channel_index);
+
+			active_buffer[current_count] = (filter_output[i] < 0) ?
+											0 : ((uint16_t)filter_output[i]) >> 3;
+
+			_data_dispatch_increment_count(filter_adc_index, channel_index);
+
+			slot++;
+			if (slot >= filter_slots_count)
+			{
+				slot = 0;
+			}
+		}
+	}
+
+	filter_busy = false;
+}
+
+/**
+ * Filter the readings stored since the previous block,
+ * unless the previous block is still being filtered.
+ * The FMAC is only started once, and again after a
+ * filter change.
+ */
+static void _data_dispatch_filter_start()
+{
+	if ( (filter_busy == true) ||
+		 (filter_stream_count[filter_filling] == 0) )
+		return;
+
+	if ( (fmac_is_started() == false) &&
+		 (fmac_start(filter_slots_count) != 0) )
+	{
+		/* Filter does not fit: readings are dropped */
+		filter_stream_count[filter_filling] = 0;
+		filter_stream_first_slot[filter_filling] = filter_next_slot;
+		return;
+	}
+
+	uint8_t filtered = filter_filling;
+
+	/* Following readings go to the other buffer */
+	filter_filling ^= 1;
+	filter_stream_count[filter_filling]      = 0;
+	filter_stream_first_slot[filter_filling] = filter_next_slot;
+
+	filter_busy = true;
+	if (fmac_dma_filter(filter_stream[filtered],
+						filter_output,
+						filter_stream_count[filtered],
+						_data_dispatch_filter_done) != 0)
+	{
+		/* FMAC is not available: readings are dropped */
+		filter_busy = false;
+	}
+}
+
+#endif
+
 /**
  * Public API
  */
@@ -137,21 +359,32 @@ void data_dispatch_init(dispatch_t dispatch_method, uint32_t repetitions)
 	/* Store dispatch method */
 	dispatch_type = dispatch_method;
 
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+	/* Buffers are laid out again on each init */
+	dispatch_pool_used = 0;
+#endif
+
 	/* Prepare arrays for each ADC */
 	enabled_channels_count =
-				(uint8_t*)    k_malloc(ADC_COUNT * sizeof(uint8_t));
+				(uint8_t*)    _data_dispatch_alloc(ADC_COUNT * sizeof(uint8_t));
 
 	adc_channel_buffers    =
-				(uint16_t****)k_calloc(ADC_COUNT,  sizeof(uint16_t***));
+				(uint16_t****)_data_dispatch_alloc(ADC_COUNT * sizeof(uint16_t***));
 
 	buffers_data_count     =
-				(uint32_t**)  k_calloc(ADC_COUNT,  sizeof(uint32_t*));
+				(uint32_t**)  _data_dispatch_alloc(ADC_COUNT * sizeof(uint32_t*));
 
 	current_buffer         =
-				(uint8_t**)   k_calloc(ADC_COUNT,  sizeof(uint8_t*));
+				(uint8_t**)   _data_dispatch_alloc(ADC_COUNT * sizeof(uint8_t*));
 
 	peek_memory            =
-				(uint16_t**)  k_calloc(ADC_COUNT,  sizeof(uint16_t*));
+				(uint16_t**)  _data_dispatch_alloc(ADC_COUNT * sizeof(uint16_t*));
+
+	averaging_sums         =
+				(uint32_t**)  _data_dispatch_alloc(ADC_COUNT * sizeof(uint32_t*));
+
+	averaging_counts       =
+				(uint8_t**)   _data_dispatch_alloc(ADC_COUNT * sizeof(uint8_t*));
 
 	/* Configure DMA 1 channels */
 	for (uint8_t adc_num = 1 ; adc_num <= ADC_COUNT ; adc_num++)
@@ -178,14 +411,20 @@ void data_dispatch_init(dispatch_t dispatch_method, uint32_t repetitions)
 			{
 				dma_buffer_size = repetitions;
 
+				/* Averaged ADCs are triggered several times per repetition */
+				if (averaging_samples[adc_index] > 1)
+				{
+					dma_buffer_size *= averaging_samples[adc_index];
+				}
+
 				/**
 				 * Make sure buffer size is a multiple of enabled channels count
 				 * so that each channel data will always be at the same position
 				 */
-				if (repetitions % enabled_channels_count[adc_index] != 0)
+				if (dma_buffer_size % enabled_channels_count[adc_index] != 0)
 				{
 					dma_buffer_size +=  (enabled_channels_count[adc_index]) -
-										(repetitions %
+										(dma_buffer_size %
 										 enabled_channels_count[adc_index]);
 				}
 				else
@@ -200,9 +439,23 @@ void data_dispatch_init(dispatch_t dispatch_method, uint32_t repetitions)
 				}
 			}
 
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+			uint8_t static_channels = DATA_STATIC_CHANNELS[adc_index];
+			if ( (enabled_channels_count[adc_index] > static_channels) ||
+				 (dma_buffer_size >
+				  _data_dispatch_static_dma_size(static_channels)) )
+			{
+				printk("ADC %u: buffers do not fit static allocation, "
+					   "acquisition disabled\n", adc_num);
+
+				enabled_channels_count[adc_index] = 0;
+				continue;
+			}
+#endif
+
 			dma_buffer_sizes[adc_index] = dma_buffer_size;
 			dma_main_buffers[adc_index] =
-					(uint16_t*)k_malloc(dma_buffer_size * sizeof(uint16_t));
+					(uint16_t*)_data_dispatch_alloc(dma_buffer_size * sizeof(uint16_t));
 
 			if (dispatch_type == interrupt)
 			{
@@ -224,26 +477,33 @@ void data_dispatch_init(dispatch_t dispatch_method, uint32_t repetitions)
 
 			/* Prepare arrays for each channel */
 			adc_channel_buffers[adc_index] =
-					(uint16_t***)k_malloc(
+					(uint16_t***)_data_dispatch_alloc(
 						enabled_channels_count[adc_index] * sizeof(uint16_t**)
 					);
 
 			buffers_data_count[adc_index] =
-					(uint32_t*)k_calloc(
-						enabled_channels_count[adc_index],
-						sizeof(uint32_t)
+					(uint32_t*)_data_dispatch_alloc(
+						enabled_channels_count[adc_index] * sizeof(uint32_t)
 					);
 
 			current_buffer[adc_index]     =
-					(uint8_t*) k_calloc(
-						enabled_channels_count[adc_index],
-						sizeof(uint8_t)
+					(uint8_t*) _data_dispatch_alloc(
+						enabled_channels_count[adc_index] * sizeof(uint8_t)
 					);
 
 			peek_memory[adc_index]        =
-					(uint16_t*)k_calloc(
-						enabled_channels_count[adc_index],
-						sizeof(uint16_t)
+					(uint16_t*)_data_dispatch_alloc(
+						enabled_channels_count[adc_index] * sizeof(uint16_t)
+					);
+
+			averaging_sums[adc_index]     =
+					(uint32_t*)_data_dispatch_alloc(
+						enabled_channels_count[adc_index] * sizeof(uint32_t)
+					);
+
+			averaging_counts[adc_index]   =
+					(uint8_t*) _data_dispatch_alloc(
+						enabled_channels_count[adc_index] * sizeof(uint8_t)
 					);
 
 			for (int channel_index = 0 ;
@@ -252,17 +512,17 @@ void data_dispatch_init(dispatch_t dispatch_method, uint32_t repetitions)
 			{
 				/* Prepare double buffer */
 				adc_channel_buffers[adc_index][channel_index] =
-					(uint16_t**)k_malloc(
+					(uint16_t**)_data_dispatch_alloc(
 									sizeof(uint16_t*) * 2
 								);
 
 				adc_channel_buffers[adc_index][channel_index][0] =
-					(uint16_t*)k_malloc(
+					(uint16_t*)_data_dispatch_alloc(
 									sizeof(uint16_t) * CHANNELS_BUFFERS_SIZE
 							   );
 
 				adc_channel_buffers[adc_index][channel_index][1] =
-					(uint16_t*)k_malloc(
+					(uint16_t*)_data_dispatch_alloc(
 									sizeof(uint16_t) * CHANNELS_BUFFERS_SIZE
 							   );
 
@@ -303,47 +563,115 @@ void data_dispatch_do_dispatch(uint8_t adc_num)
 		data_count_in_dma_buffer = dma_get_retrieved_data_count(adc_num);
 	}
 
+	/**
+	 * DMA buffer size is a multiple of the enabled channels count, so
+	 * channel index can be tracked alongside the DMA buffer index rather
+	 * than recomputed with a division for each sample.
+	 */
+	static size_t next_dma_buffer_index[ADC_COUNT] = {0};
+	static size_t next_channel_index[ADC_COUNT]    = {0};
+
+	size_t channels_count   = enabled_channels_count[adc_index];
+	uint8_t averaging       = averaging_samples[adc_index];
+	size_t dma_buffer_index = 0;
+	size_t channel_index    = 0;
+
+	if (dispatch_type == task)
+	{
+		dma_buffer_index = next_dma_buffer_index[adc_index];
+		channel_index    = next_channel_index[adc_index];
+	}
+
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+	uint32_t filtered_mask = filtered_channels_mask[adc_index];
+	bool     filtering     = (filtered_mask != 0) && fmac_is_loaded();
+#endif
+
 	for (size_t dma_index = 0 ;
 		 dma_index < data_count_in_dma_buffer ;
 		 dma_index++)
 	{
+		/* Get info on buffer */
+		uint16_t* active_buffer =
+					_data_dispatch_get_buffer(adc_index, channel_index);
+
+		uint32_t  current_count =
+					_data_dispatch_get_count(adc_index, channel_index);
+
 		/* Copy data */
-		size_t dma_buffer_index;
-		if (dispatch_type == interrupt)
+		uint16_t value = dma_buffer[dma_buffer_index];
+
+		/* Move to next DMA buffer cell */
+		dma_buffer_index++;
+		if (dma_buffer_index >= dma_buffer_sizes[adc_index])
 		{
-			dma_buffer_index = dma_index % enabled_channels_count[adc_index];
+			dma_buffer_index = 0;
 		}
-		else
+
+		if (averaging > 1)
 		{
-			static size_t next_dma_buffer_index[ADC_COUNT] = {0};
+			uint32_t* sum   = &averaging_sums[adc_index][channel_index];
+			uint8_t*  count = &averaging_counts[adc_index][channel_index];
 
-			dma_buffer_index = next_dma_buffer_index[adc_index];
+			*sum += value;
+			(*count)++;
 
-			if (next_dma_buffer_index[adc_index] < dma_buffer_sizes[adc_index] - 1)
+			if ((*count) < averaging)
 			{
-				next_dma_buffer_index[adc_index]++;
+				/* Wait for the following readings of this channel */
+				channel_index++;
+				if (channel_index >= channels_count)
+				{
+					channel_index = 0;
+				}
+				continue;
 			}
-			else
+
+			value = (*sum + averaging / 2) / averaging;
+			*sum   = 0;
+			*count = 0;
+		}
+
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+		if ( (filtering == true) &&
+			 ((filtered_mask & (1UL << channel_index)) != 0) )
+		{
+			/* Stored in channel buffer once filtered */
+			_data_dispatch_filter_stage(channel_index, value);
+
+			channel_index++;
+			if (channel_index >= channels_count)
 			{
-				next_dma_buffer_index[adc_index] = 0;
+				channel_index = 0;
 			}
+			continue;
 		}
+#endif
 
-		/* Get info on buffer */
-		size_t channel_index =
-					dma_buffer_index % enabled_channels_count[adc_index];
+		active_buffer[current_count] = value;
 
-		uint16_t* active_buffer =
-					_data_dispatch_get_buffer(adc_index, channel_index);
+		/* Increment count */
+		_data_dispatch_increment_count(adc_index, channel_index);
 
-		uint32_t  current_count =
-					_data_dispatch_get_count(adc_index, channel_index);
+		channel_index++;
+		if (channel_index >= channels_count)
+		{
+			channel_index = 0;
+		}
+	}
 
-		active_buffer[current_count] = dma_buffer[dma_buffer_index];
+	if (dispatch_type == task)
+	{
+		next_dma_buffer_index[adc_index] = dma_buffer_index;
+		next_channel_index[adc_index]    = channel_index;
+	}
 
-		/* Increment count */
-		_data_dispatch_increment_count(adc_index, channel_index);
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+	if (filtering == true)
+	{
+		_data_dispatch_filter_start();
 	}
+#endif
 }
 
 void data_dispatch_do_full_dispatch()
@@ -354,6 +682,89 @@ void data_dispatch_do_full_dispatch()
 	}
 }
 
+void data_dispatch_set_averaging(uint8_t adc_number, uint8_t samples_count)
+{
+	uint8_t adc_index = adc_number-1;
+	if (adc_index >= ADC_COUNT)
+		return;
+
+	averaging_samples[adc_index] = samples_count;
+
+	/* Drop readings accumulated with the previous setting */
+	if ( (averaging_sums == nullptr) ||
+		 (averaging_sums[adc_index] == nullptr) )
+		return;
+
+	for (uint8_t channel_index = 0 ;
+		 channel_index < enabled_channels_count[adc_index] ;
+		 channel_index++)
+	{
+		averaging_sums[adc_index][channel_index]   = 0;
+		averaging_counts[adc_index][channel_index] = 0;
+	}
+}
+
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+
+int8_t data_dispatch_set_hardware_filter(uint8_t adc_number,
+										 uint8_t channel_rank,
+										 bool enable)
+{
+	uint8_t adc_index     = adc_number - 1;
+	uint8_t channel_index = channel_rank - 1;
+	if ( (adc_index >= ADC_COUNT) || (channel_index >= 32) )
+		return -1;
+
+	unsigned int key = irq_lock();
+
+	uint32_t mask = filtered_channels_mask[adc_index];
+	if (enable == true)
+		mask |= (1UL << channel_index);
+	else
+		mask &= ~(1UL << channel_index);
+
+	if (mask == filtered_channels_mask[adc_index])
+	{
+		irq_unlock(key);
+		return 0;
+	}
+
+	/* All filtered channels are interleaved in the stream of one ADC */
+	if ( (__builtin_popcount(mask) > FILTERED_CHANNELS_MAX) ||
+		 ( (filtered_channels_mask[filter_adc_index] != 0) &&
+		   (filter_adc_index != adc_index) ) )
+	{
+		irq_unlock(key);
+		return -1;
+	}
+
+	/* Filter is started again with the new stream by the next dispatch */
+	fmac_stop();
+
+	filtered_channels_mask[adc_index] = mask;
+	filter_adc_index   = adc_index;
+	filter_slots_count = 0;
+	for (uint8_t i = 0 ; i < 32 ; i++)
+	{
+		if ((mask & (1UL << i)) != 0)
+		{
+			filter_slots[filter_slots_count] = i;
+			filter_slots_count++;
+		}
+	}
+
+	filter_next_slot = 0;
+	filter_filling   = 0;
+	filter_stream_count[0]      = 0;
+	filter_stream_first_slot[0] = 0;
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+#endif
+
 /**
  *  Accessors
  */
@@ -372,6 +783,9 @@ uint16_t* data_dispatch_get_acquired_values(uint8_t adc_number,
 
 	/* Get and check data count */
 	uint8_t channel_index = channel_rank-1;
+	if (channel_index >= enabled_channels_count[adc_index])
+		return nullptr;
+
 	uint32_t current_count =
 				_data_dispatch_get_count(adc_index, channel_index);
 
@@ -400,7 +814,8 @@ uint16_t data_dispatch_peek_acquired_value(uint8_t adc_number,
 {
 	uint8_t adc_index = adc_number-1;
 	uint8_t channel_index = channel_rank-1;
-	if (adc_index < ADC_COUNT)
+	if ( (adc_index < ADC_COUNT) &&
+		 (channel_index < enabled_channels_count[adc_index]) )
 	{
 		/* Get info on buffer */
 		uint16_t* active_buffer =
@@ -38,12 +38,76 @@
 /* Stdlib */
 #include <stdint.h>
 
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+/* Zephyr */
+#include <zephyr/devicetree.h>
+#endif
+
 
 /* Constants */
 
 const uint16_t PEEK_NO_VALUE = 0xFFFF;
 const uint8_t CHANNELS_BUFFERS_SIZE = 32;
 
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+const uint8_t FILTERED_CHANNELS_MAX = 4;
+#endif
+
+#ifdef CONFIG_OWNTECH_STATIC_ALLOCATION
+
+/**
+ * In static allocation mode, buffers are sized at compile time for the
+ * sensors declared in the device tree on each ADC, plus a number of extra
+ * channels that can be enabled directly from the Data API.
+ */
+#define DATA_DT_SENSOR_ON_ADC(node_id, adc_label)                          \
+	+ (DT_SAME_NODE(DT_PHANDLE(node_id, io_channels), DT_NODELABEL(adc_label)) ? 1 : 0)
+
+#define DATA_DT_SUBSENSORS_ON_ADC(node_id, adc_label) \
+	DT_FOREACH_CHILD_VARGS(node_id, DATA_DT_SENSOR_ON_ADC, adc_label)
+
+#define DATA_STATIC_CHANNELS_COUNT(adc_label)                               \
+	(CONFIG_OWNTECH_STATIC_ALLOCATION_EXTRA_CHANNELS                        \
+	 DT_FOREACH_STATUS_OKAY_VARGS(shield_sensors,                           \
+								  DATA_DT_SUBSENSORS_ON_ADC,                \
+								  adc_label))
+
+/* Maximum number of enabled channels for each ADC (cell i is ADC i+1) */
+const uint8_t DATA_STATIC_CHANNELS[] =
+{
+	DATA_STATIC_CHANNELS_COUNT(adc1),
+	DATA_STATIC_CHANNELS_COUNT(adc2),
+	DATA_STATIC_CHANNELS_COUNT(adc3),
+	DATA_STATIC_CHANNELS_COUNT(adc4),
+	DATA_STATIC_CHANNELS_COUNT(adc5)
+};
+
+/* Maximum number of enabled channels for all ADCs */
+const uint16_t DATA_STATIC_CHANNELS_TOTAL = DATA_STATIC_CHANNELS_COUNT(adc1) +
+											DATA_STATIC_CHANNELS_COUNT(adc2) +
+											DATA_STATIC_CHANNELS_COUNT(adc3) +
+											DATA_STATIC_CHANNELS_COUNT(adc4) +
+											DATA_STATIC_CHANNELS_COUNT(adc5);
+
+/**
+ * @brief Get the index of the first channel of an ADC in arrays holding
+ *        DATA_STATIC_CHANNELS_TOTAL channels.
+ *
+ * @param adc_index Index of the ADC (ADC number - 1).
+ */
+static inline uint16_t data_static_channels_offset(uint8_t adc_index)
+{
+	uint16_t offset = 0;
+	for (uint8_t i = 0 ; i < adc_index ; i++)
+	{
+		offset += DATA_STATIC_CHANNELS[i];
+	}
+
+	return offset;
+}
+
+#endif /* CONFIG_OWNTECH_STATIC_ALLOCATION */
+
 /**
  * Dispatch method
  */
@@ -114,5 +178,43 @@ uint16_t* data_dispatch_get_acquired_values(uint8_t adc_number,
 uint16_t data_dispatch_peek_acquired_value(uint8_t adc_number,
                                            uint8_t channel_rank);
 
+/**
+ * @brief  Average consecutive readings of each channel of an ADC
+ *         as they are dispatched, so that channel buffers hold
+ *         one value for each set of readings.
+ *
+ * @param  adc_number Number of the ADC to configure.
+ * @param  samples_count Number of readings averaged into one
+ *         value, 0 or 1 to store each reading.
+ */
+void data_dispatch_set_averaging(uint8_t adc_number, uint8_t samples_count);
+
+#ifdef CONFIG_OWNTECH_FMAC_DRIVER
+
+/**
+ * @brief  Route the values of a channel through the FMAC filter
+ *         as they are dispatched, so that channel buffers hold
+ *         filtered values. Readings of each dispatch are filtered
+ *         by DMA in the background and stored in the channel buffers
+ *         by the FMAC interrupt once done.
+ *         Up to FILTERED_CHANNELS_MAX channels of the same ADC, all
+ *         with the same filter, can be filtered: their readings are
+ *         interleaved into one stream that the FMAC filters without
+ *         being restarted between dispatches.
+ *
+ * @param  adc_number Number of the ADC of the channel.
+ * @param  channel_rank Rank of the channel to filter.
+ * @param  enable true to filter the channel, false to stop filtering it.
+ *
+ * @return 0 if filtering was enabled or disabled, -1 if the
+ *         channel is invalid, FILTERED_CHANNELS_MAX channels
+ *         are already filtered or filtered channels belong to
+ *         another ADC.
+ */
+int8_t data_dispatch_set_hardware_filter(uint8_t adc_number,
+                                         uint8_t channel_rank,
+                                         bool enable);
+
+#endif
 
 #endif /* DATA_DISPATCH_H_ */
@@ -34,7 +34,6 @@
 /* Zephyr */
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
-#include <zephyr/console/console.h>
 
 /* STM32 LL */
 #include <stm32_ll_bus.h>
@@ -42,6 +41,7 @@
 
 /* Owntech driver */
 #include "dac.h"
+#include "console_input.h"
 
 static const struct device* dac2 = DEVICE_DT_GET(DAC2_DEVICE);
 
@@ -86,15 +86,15 @@ static int _dac2_init()
 }
 
 /**
- * @brief Initialize the console backend (e.g., UART).
+ * @brief Initialize the console input (e.g., UART).
  *
- * Calls the console_init function defined elsewhere in the system.
+ * Starts interrupt-driven reception of the console input driver.
  *
  * @return Always returns 0 (success).
  */
 static int _console_init()
 {
-	console_init();
+	console_input_init();
 
 	return 0;
 }
@@ -134,6 +134,14 @@ static int _img_validation()
 #include <zephyr/retention/bootmode.h>
 #include <zephyr/sys/reboot.h>
 
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+#include "retained_state.h"
+#endif
+
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+#include "nvs_storage.h"
+#endif
+
 /**
  * @brief Submit a warm reboot into bootloader mode.
  *
@@ -143,6 +151,14 @@ static int _img_validation()
  */
 void reboot_bootloader_task(struct k_work* work)
 {
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	/* Firmware is about to change, next boot must not restore state */
+	retained_state_clear();
+#endif
+#ifdef CONFIG_OWNTECH_FLASH_WRITE_CACHE
+	/* Data stored before the reboot must reach flash */
+	nvs_storage_flush();
+#endif
 	bootmode_set(BOOT_MODE_TYPE_BOOTLOADER);
 	sys_reboot(SYS_REBOOT_WARM);
 }
@@ -186,6 +202,36 @@ static int _register_cdc_rate_callback()
 		* CONFIG_USB_CDC_ACM */
 
 
+#if CONFIG_OWNTECH_COLD_BOOT_DELAY_MS > 0
+
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+#include "retained_state.h"
+#endif
+
+/**
+ * @brief Wait before starting the application on cold boot.
+ *
+ * Leaves time to open the USB console to see boot messages, without
+ * delaying the application after a warm boot.
+ *
+ * @return Always returns 0 (success).
+ */
+static int _cold_boot_delay()
+{
+#ifdef CONFIG_OWNTECH_RETAINED_STATE_DRIVER
+	if (retained_state_is_warm_boot() == true)
+	{
+		return 0;
+	}
+#endif
+
+	k_msleep(CONFIG_OWNTECH_COLD_BOOT_DELAY_MS);
+
+	return 0;
+}
+#endif /* CONFIG_OWNTECH_COLD_BOOT_DELAY_MS > 0 */
+
+
 #ifdef CONFIG_SHIELD_O2
 #include <stm32_ll_lpuart.h>
 /**
@@ -228,6 +274,14 @@ SYS_INIT(_console_init,
          89
         );
 
+#if CONFIG_OWNTECH_COLD_BOOT_DELAY_MS > 0
+/* After the retained state driver has read the reset cause */
+SYS_INIT(_cold_boot_delay,
+         APPLICATION,
+         91
+        );
+#endif /* CONFIG_OWNTECH_COLD_BOOT_DELAY_MS > 0 */
+
 #ifdef CONFIG_BOOTLOADER_MCUBOOT
 SYS_INIT(_img_validation,
          APPLICATION,
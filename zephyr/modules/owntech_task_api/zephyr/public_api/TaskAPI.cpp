@@ -66,6 +66,15 @@ void TaskAPI::stopCritical()
 	scheduling_stop_uninterruptible_synchronous_task();
 }
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+
+void TaskAPI::setTimingPins(uint8_t task_pin, uint8_t stage_pin)
+{
+	scheduling_set_timing_pins(task_pin, stage_pin);
+}
+
+#endif
+
 
 /* Asynchronous tasks */
 
@@ -127,6 +127,26 @@ public:
 	 */
 	void stopCritical();
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+	/**
+	 * @brief Set the timing pins of the critical task, to measure
+	 *        its execution window, jitter and latency with a scope.
+	 *
+	 *        The task pin is high from task entry to task exit. The stage
+	 *        pin is high during safety check and data dispatch, then falls
+	 *        when the user function is called.
+	 *        When this function is not called, pins defined in Kconfig
+	 *        (`CONFIG_OWNTECH_TASK_TIMING_PIN_TASK` and
+	 *        `CONFIG_OWNTECH_TASK_TIMING_PIN_STAGES`) are used.
+	 *
+	 * @param task_pin  Spin pin number, `0` for none.
+	 * @param stage_pin Spin pin number, `0` for none.
+	 *
+	 * @warning Call this function before startCritical().
+	 */
+	void setTimingPins(uint8_t task_pin, uint8_t stage_pin = 0);
+#endif
+
 
 #ifdef CONFIG_OWNTECH_TASK_ENABLE_ASYNCHRONOUS_TASKS
 
@@ -70,6 +70,13 @@ static uint32_t task_period = 0;
 /* Safety */
 static bool safety_alert = false;
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+/* Timing pins, disabled when bsrr is NULL */
+static bool timing_pins_set = false;
+static fast_pin_t task_timing_pin  = {NULL, NULL, 0};
+static fast_pin_t stage_timing_pin = {NULL, NULL, 0};
+#endif
+
 /* Private API */
 
 #ifdef CONFIG_OWNTECH_SAFETY_API
@@ -104,22 +111,65 @@ void thread_error(void *, void *, void *)
 }
 #endif
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+
+static fast_pin_t _scheduling_get_timing_pin(uint8_t pin)
+{
+	if (pin == 0)
+	{
+		fast_pin_t no_pin = {NULL, NULL, 0};
+		return no_pin;
+	}
+
+	spin.gpio.configurePin(pin, OUTPUT);
+	spin.gpio.resetPin(pin);
+
+	return spin.gpio.getFastPin(pin);
+}
+
+static inline void _scheduling_timing_pin_set(fast_pin_t pin)
+{
+	if (pin.bsrr != NULL) spin.gpio.setFastPin(pin);
+}
+
+static inline void _scheduling_timing_pin_reset(fast_pin_t pin)
+{
+	if (pin.bsrr != NULL) spin.gpio.resetFastPin(pin);
+}
+
+#endif
+
 void user_task_proxy()
 {
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+	_scheduling_timing_pin_set(task_timing_pin);
+	_scheduling_timing_pin_set(stage_timing_pin);
+#endif
+
 #ifdef CONFIG_OWNTECH_SAFETY_API
 
 	if (safety_task() != 0) safety_alert = true;
 
 #endif
 
-	if (user_periodic_task == NULL) return;
-
-	if (do_data_dispatch == true)
+	if (user_periodic_task != NULL)
 	{
-		spin.data.doFullDispatch();
+		if (do_data_dispatch == true)
+		{
+			spin.data.doFullDispatch();
+		}
+
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+		_scheduling_timing_pin_reset(stage_timing_pin);
+#endif
+
+		user_periodic_task();
 	}
 
-	user_periodic_task();
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+	_scheduling_timing_pin_reset(stage_timing_pin);
+	_scheduling_timing_pin_reset(task_timing_pin);
+#endif
 }
 
 /* Public API */
@@ -199,6 +249,14 @@ void scheduling_start_uninterruptible_synchronous_task(
 	if (interrupt_source == scheduling_interrupt_source_t::source_uninitialized)
 		return;
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+	if (timing_pins_set == false)
+	{
+		scheduling_set_timing_pins(CONFIG_OWNTECH_TASK_TIMING_PIN_TASK,
+								   CONFIG_OWNTECH_TASK_TIMING_PIN_STAGES);
+	}
+#endif
+
 	if ( (manage_data_acquisition == true) && (spin.data.started() == false) )
 	{
 		/**
@@ -272,3 +330,23 @@ void scheduling_stop_uninterruptible_synchronous_task()
 		uninterruptibleTaskStatus = task_status_t::suspended;
 	}
 }
+
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+
+void scheduling_set_timing_pins(uint8_t task_pin, uint8_t stage_pin)
+{
+	timing_pins_set = true;
+
+	/* Pins are not driven while handles are being replaced */
+	fast_pin_t no_pin = {NULL, NULL, 0};
+	task_timing_pin  = no_pin;
+	stage_timing_pin = no_pin;
+
+	fast_pin_t new_stage_pin = _scheduling_get_timing_pin(stage_pin);
+	fast_pin_t new_task_pin  = _scheduling_get_timing_pin(task_pin);
+
+	stage_timing_pin = new_stage_pin;
+	task_timing_pin  = new_task_pin;
+}
+
+#endif
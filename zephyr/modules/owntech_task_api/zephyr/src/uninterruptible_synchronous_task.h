@@ -86,5 +86,21 @@ void scheduling_start_uninterruptible_synchronous_task(
  */
 void scheduling_stop_uninterruptible_synchronous_task();
 
+#ifdef CONFIG_OWNTECH_TASK_ENABLE_TIMING_PINS
+
+/**
+ * @brief Set the pins driven by the uninterruptible synchronous task.
+ *
+ * Pins are configured as outputs. When not called, pins defined
+ * in Kconfig are used when the task is started.
+ *
+ * @param task_pin  Spin pin high during the whole task, `0` for none.
+ * @param stage_pin Spin pin high during safety check and data dispatch,
+ *                  `0` for none.
+ */
+void scheduling_set_timing_pins(uint8_t task_pin, uint8_t stage_pin);
+
+#endif
+
 
 #endif /* UNINTERRUPTIBLESYNCHRONOUSTASK_H_ */